@@ -0,0 +1,290 @@
+// Micro-benchmarks for the paste hot path: clipboard normalization,
+// encoding, event buffer construction, settings access and a whole paste
+// against a null backend. Run with an optional name filter, e.g.
+//   clickpaste_bench encode
+//   clickpaste_bench coalesce
+
+#include "eventencoder.h"
+#include "nullbackend.h"
+#include "settings.h"
+#include "textnormalizer.h"
+#include "typingoptions.h"
+#include "typingworker.h"
+
+#include <QByteArray>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QStandardPaths>
+#include <QStringList>
+#include <QVector>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <memory>
+#include <new>
+
+namespace {
+
+std::atomic<qint64> allocationCount{0};
+
+// Each benchmark runs for at least this long after one warm-up round
+constexpr qint64 MinRunNs = 200 * 1000 * 1000;
+constexpr int MinIterations = 5;
+
+// Roughly what a large paste of source code or prose looks like
+QByteArray makeClipboard(qsizetype size)
+{
+    static const char* const lines[] = {
+        "The quick brown fox jumps over the lazy dog.\r\n",
+        "    if (value > limit) { return -1; } // clamp\r\n",
+        "Caf\xc3\xa9 cr\xc3\xa8me br\xc3\xbbl\xc3\xa9" "e \xe2\x80\x94 na\xc3\xafve r\xc3\xa9sum\xc3\xa9\r\n",
+        "user@example.com: ~/src $ make -j8 && ./run --all\r\n",
+        "\r\n",
+    };
+
+    QByteArray text;
+    text.reserve(size);
+    for (int i = 0; text.size() < size; ++i) {
+        text.append(lines[i % std::size(lines)]);
+    }
+    return text;
+}
+
+// Inputs where Shift handling matters, from all caps to mostly lower case
+struct CaseSample
+{
+    const char* name;
+    QByteArray text;
+};
+
+QByteArray repeatTo(const char* unit, qsizetype size)
+{
+    QByteArray text;
+    text.reserve(size + qstrlen(unit));
+    while (text.size() < size) {
+        text.append(unit);
+    }
+    return text;
+}
+
+QVector<CaseSample> caseSamples(const QByteArray& prose)
+{
+    constexpr qsizetype Size = 64 * 1024;
+    return {
+        {"hex-key", repeatTo("3F9A0C7EB21D44E8A6C5F0197D3B8E2A\n", Size)},
+        {"base32-token", repeatTo("JBSWY3DPEHPK3PXPMFRGGZDFMZTWQ2LK\n", Size)},
+        {"license-key", repeatTo("M7QX4-HT9KB-PW2RD-FJ8YC-3GVXN\n", Size)},
+        {"sql", repeatTo("SELECT ID, NAME FROM USERS WHERE CREATED_AT > NOW() - INTERVAL '1 DAY' ORDER BY ID;\n",
+                         Size)},
+        {"mixed-case", repeatTo("HELLO World, ThisIsCamelCase and SOME_CONSTANT = getValue();\n", Size)},
+        {"prose", prose.left(Size)},
+    };
+}
+
+qsizetype countCharacters(const QByteArray& text)
+{
+    TextNormalizer::Stats stats;
+    TextNormalizer::normalized(text, &stats);
+    return stats.characters;
+}
+
+class Runner
+{
+public:
+    explicit Runner(const QStringList& filters)
+        : m_filters(filters)
+    {
+        std::printf("%-34s %10s %14s %10s %10s\n",
+                    "benchmark", "iterations", "ns/op", "ns/char", "allocs/op");
+    }
+
+    // characters is how many characters one call of fn handles. Returns
+    // false if the name did not match the filters and nothing ran.
+    template<typename Fn>
+    bool run(const char* name, qsizetype characters, Fn fn)
+    {
+        if (!matches(QString::fromLatin1(name))) {
+            return false;
+        }
+
+        fn();
+
+        const qint64 allocationsBefore = allocationCount.load(std::memory_order_relaxed);
+        qint64 iterations = 0;
+        QElapsedTimer timer;
+        timer.start();
+        do {
+            fn();
+            ++iterations;
+        } while (iterations < MinIterations || timer.nsecsElapsed() < MinRunNs);
+        const qint64 elapsed = timer.nsecsElapsed();
+        const qint64 allocations = allocationCount.load(std::memory_order_relaxed) - allocationsBefore;
+
+        const double nsPerOp = double(elapsed) / iterations;
+        std::printf("%-34s %10lld %14.1f %10.3f %10.1f\n", name,
+                    static_cast<long long>(iterations), nsPerOp,
+                    nsPerOp / qMax<qsizetype>(characters, 1),
+                    double(allocations) / iterations);
+        std::fflush(stdout);
+        return true;
+    }
+
+private:
+    bool matches(const QString& name) const
+    {
+        if (m_filters.isEmpty()) {
+            return true;
+        }
+        for (const QString& filter : m_filters) {
+            if (name.contains(filter)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    QStringList m_filters;
+};
+
+} // namespace
+
+// Counts every heap allocation made by the process
+void* operator new(std::size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    // Built without exceptions, like the rest of the tree
+    std::abort();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    // Keep Settings away from the user's configuration
+    QStandardPaths::setTestModeEnabled(true);
+
+    QStringList filters = QCoreApplication::arguments();
+    filters.removeFirst();
+
+    Runner runner(filters);
+
+    const QByteArray clipboard = makeClipboard(1 << 20);
+    TextNormalizer::Stats stats;
+    const QByteArray text = TextNormalizer::normalized(clipboard, &stats);
+    const qsizetype characters = stats.characters;
+
+    runner.run("normalize/crlf-1MiB", characters, [&]() {
+        QByteArray out = TextNormalizer::normalized(clipboard);
+        Q_UNUSED(out)
+    });
+
+    runner.run("normalize/lf-1MiB", characters, [&]() {
+        QByteArray out = TextNormalizer::normalized(text);
+        Q_UNUSED(out)
+    });
+
+    EventEncoder encoder;
+    EventBuffer buffer;
+
+    runner.run("encode/whole-text", characters, [&]() {
+        buffer.clear();
+        encoder.encode(text, buffer);
+    });
+
+    // The paced path, one character at a time into the buffer
+    runner.run("encode/per-character", characters, [&]() {
+        buffer.clear();
+        for (qsizetype i = 0; i < text.size();) {
+            const char32_t ch = EventEncoder::nextCodePoint(text, i);
+            buffer.commit(encoder.encodeCharacter(ch, buffer.prepare(EventEncoder::MaxEventsPerChar)));
+        }
+    });
+
+    runner.run("eventbuffer/fresh-per-paste", characters, [&]() {
+        EventBuffer fresh;
+        encoder.encode(text, fresh);
+    });
+
+    // Events per character with Shift pressed for every capital and with
+    // Shift held across runs; every event is a write to uinput or a
+    // datagram to ydotoold, and a KVM turns each one into a HID report
+    struct CoalesceResult
+    {
+        const char* name;
+        double plain;
+        double coalesced;
+    };
+    QVector<CoalesceResult> coalesceResults;
+    for (const CaseSample& sample : caseSamples(text)) {
+        const qsizetype sampleCharacters = countCharacters(sample.text);
+        CoalesceResult result = {sample.name, 0, 0};
+        for (bool coalesce : {false, true}) {
+            EventEncoder sampleEncoder;
+            sampleEncoder.setCoalesceModifiers(coalesce);
+            const QByteArray name = QByteArray("coalesce/") + sample.name + (coalesce ? "-on" : "-off");
+            const bool ran = runner.run(name.constData(), sampleCharacters, [&]() {
+                buffer.clear();
+                sampleEncoder.resetModifiers();
+                sampleEncoder.encode(sample.text, buffer);
+            });
+            if (ran) {
+                (coalesce ? result.coalesced : result.plain) = double(buffer.size()) / sampleCharacters;
+            }
+        }
+        if (result.plain > 0 && result.coalesced > 0) {
+            coalesceResults.append(result);
+        }
+    }
+    if (!coalesceResults.isEmpty()) {
+        std::printf("\n%-34s %12s %12s %10s\n", "events per character", "per-char", "coalesced", "saved");
+        for (const CoalesceResult& result : std::as_const(coalesceResults)) {
+            std::printf("%-34s %12.2f %12.2f %9.1f%%\n", result.name, result.plain, result.coalesced,
+                        100.0 * (result.plain - result.coalesced) / result.plain);
+        }
+        std::printf("\n");
+    }
+
+    runner.run("settings/typing-options", 1, [&]() {
+        const TypingOptions options = typingOptions(*Settings::instance()->snapshot());
+        Q_UNUSED(options)
+    });
+
+    TypingWorker worker;
+    auto backend = std::make_unique<NullBackend>();
+    NullBackend* sink = backend.get();
+    backend->open();
+    worker.setBackend(std::move(backend));
+
+    TypingOptions unpaced;
+    unpaced.keyDelayMs = 0;
+
+    runner.run("paste/null-backend", characters, [&]() {
+        worker.typeText(text, static_cast<int>(characters), unpaced);
+    });
+
+    // Small pastes are dominated by per-paste overhead
+    const QByteArray line = text.left(64);
+    runner.run("paste/null-backend-64-chars", 64, [&]() {
+        worker.typeText(line, 64, unpaced);
+    });
+
+    if (sink->writes() > 0) {
+        std::printf("\nnull backend: %.1f events per write\n", double(sink->events()) / sink->writes());
+    }
+
+    return 0;
+}
@@ -0,0 +1,235 @@
+// End-to-end latency and throughput of the typing engine against a mock
+// ydotoold. Needs no desktop, compositor or /dev/uinput: InputEmulator is
+// pointed at the mock through YDOTOOL_SOCKET, exactly as a user would
+// point it at a non-default daemon.
+
+#include "inputemulator.h"
+#include "mockydotoold.h"
+#include "pacer.h"
+#include "typingoptions.h"
+
+#include <QByteArray>
+#include <QCoreApplication>
+#include <QEventLoop>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTimer>
+#include <QVector>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace {
+
+constexpr int LatencyRuns = 50;
+constexpr int ThroughputChars = 5000;
+constexpr int JitterChars = 300;
+constexpr int JitterDelayMs = 5;
+constexpr int UppercaseChars = 4000;
+
+constexpr double NsPerMs = 1e6;
+constexpr double NsPerUs = 1e3;
+
+// Runs the event loop until the current paste is over
+bool waitForPaste(InputEmulator& emulator, int timeoutMs)
+{
+    QEventLoop loop;
+    bool ok = true;
+    QObject::connect(&emulator, &InputEmulator::typingFinished, &loop, &QEventLoop::quit);
+    QObject::connect(&emulator, &InputEmulator::typingCancelled, &loop, &QEventLoop::quit);
+    QObject::connect(&emulator, &InputEmulator::errorOccurred, &loop, [&](const QString& error) {
+        std::fprintf(stderr, "error: %s\n", qPrintable(error));
+        ok = false;
+        loop.quit();
+    });
+    QTimer::singleShot(timeoutMs, &loop, [&]() {
+        std::fprintf(stderr, "error: paste timed out\n");
+        ok = false;
+        loop.quit();
+    });
+    loop.exec();
+    return ok;
+}
+
+void printSummary(const char* name, QVector<double> values, const char* unit)
+{
+    if (values.isEmpty()) {
+        std::printf("%-28s no samples\n", name);
+        return;
+    }
+    std::sort(values.begin(), values.end());
+    const auto at = [&](double q) {
+        return values.at(qMin<qsizetype>(values.size() - 1, qsizetype(q * values.size())));
+    };
+    std::printf("%-28s min %9.1f  p50 %9.1f  p99 %9.1f  max %9.1f %s (n=%lld)\n",
+                name, values.first(), at(0.5), at(0.99), values.last(), unit,
+                static_cast<long long>(values.size()));
+}
+
+// Key presses other than Shift, which is what a user sees as a keystroke
+QVector<qint64> keyPressTimes(const QVector<MockYdotoold::Record>& records)
+{
+    QVector<qint64> times;
+    for (const MockYdotoold::Record& record : records) {
+        if (record.event.type == EV_KEY && record.event.value == 1
+            && record.event.code != KEY_LEFTSHIFT) {
+            times.append(record.timestampNs);
+        }
+    }
+    return times;
+}
+
+QByteArray sampleText(int characters)
+{
+    static const char alphabet[] = "the quick brown fox jumps over the lazy dog ";
+    QByteArray text(characters, Qt::Uninitialized);
+    for (int i = 0; i < characters; ++i) {
+        text[i] = alphabet[i % (sizeof(alphabet) - 1)];
+    }
+    return text;
+}
+
+// Upper case with some punctuation, like SQL or a license key
+QByteArray uppercaseText(int characters)
+{
+    static const char alphabet[] = "SELECT ID, NAME FROM USERS WHERE ACTIVE = 1 ORDER BY ID; ";
+    QByteArray text(characters, Qt::Uninitialized);
+    for (int i = 0; i < characters; ++i) {
+        text[i] = alphabet[i % (sizeof(alphabet) - 1)];
+    }
+    return text;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QTemporaryDir dir;
+    if (!dir.isValid()) {
+        std::fprintf(stderr, "Could not create a temporary directory\n");
+        return 1;
+    }
+
+    const QString socketPath = dir.filePath(QStringLiteral("ydotoold.sock"));
+    MockYdotoold daemon;
+    if (!daemon.start(socketPath)) {
+        std::fprintf(stderr, "%s\n", qPrintable(daemon.errorString()));
+        return 1;
+    }
+    qputenv("YDOTOOL_SOCKET", QFile::encodeName(socketPath));
+
+    InputEmulator emulator;
+    bool ready = false;
+    QEventLoop startup;
+    QObject::connect(&emulator, &InputEmulator::initialized, &startup, [&](bool ok) {
+        ready = ok;
+        startup.quit();
+    });
+    emulator.initialize();
+    startup.exec();
+    if (!ready) {
+        std::fprintf(stderr, "InputEmulator did not connect to the mock daemon\n");
+        return 1;
+    }
+
+    TypingOptions unpaced;
+    unpaced.keyDelayMs = 0;
+
+    // Time from handing text to the emulator, which is what the hotkey
+    // handler does, until the first key reaches the daemon
+    QVector<double> latencies;
+    const QByteArray single = QByteArrayLiteral("a");
+    for (int i = 0; i < LatencyRuns; ++i) {
+        daemon.clear();
+        const qint64 start = Pacer::now();
+        emulator.typeText(single, 1, unpaced);
+        if (!waitForPaste(emulator, 5000) || !daemon.waitForCount(1, 1000)) {
+            return 1;
+        }
+        latencies.append((daemon.records().first().timestampNs - start) / NsPerUs);
+    }
+    printSummary("hotkey-to-first-key", latencies, "us");
+
+    // Sustained rate without any key delay
+    daemon.clear();
+    const QByteArray bulk = sampleText(ThroughputChars);
+    emulator.typeText(bulk, ThroughputChars, unpaced);
+    if (!waitForPaste(emulator, 60000)) {
+        return 1;
+    }
+    daemon.waitForQuiet(50);
+    const QVector<qint64> bulkKeys = keyPressTimes(daemon.records());
+    if (bulkKeys.size() > 1) {
+        const double seconds = (bulkKeys.last() - bulkKeys.first()) / 1e9;
+        std::printf("%-28s %.0f keys/s (%lld keys in %.1f ms)\n", "sustained-throughput",
+                    seconds > 0 ? (bulkKeys.size() - 1) / seconds : 0.0,
+                    static_cast<long long>(bulkKeys.size()), seconds * 1000);
+    }
+
+    // Deviation of each gap from the configured key delay
+    TypingOptions paced;
+    paced.keyDelayMs = JitterDelayMs;
+    daemon.clear();
+    emulator.typeText(sampleText(JitterChars), JitterChars, paced);
+    if (!waitForPaste(emulator, 60000)) {
+        return 1;
+    }
+    daemon.waitForQuiet(50);
+    const QVector<qint64> pacedKeys = keyPressTimes(daemon.records());
+    QVector<double> jitter;
+    double sum = 0;
+    double sumSquares = 0;
+    for (qsizetype i = 1; i < pacedKeys.size(); ++i) {
+        const double gapMs = (pacedKeys.at(i) - pacedKeys.at(i - 1)) / NsPerMs;
+        jitter.append(std::abs(gapMs - JitterDelayMs) * 1000);
+        sum += gapMs;
+        sumSquares += gapMs * gapMs;
+    }
+    printSummary("inter-key-jitter", jitter, "us");
+    if (!jitter.isEmpty()) {
+        const double mean = sum / jitter.size();
+        std::printf("%-28s mean %.3f ms, stddev %.3f ms (target %d ms)\n", "inter-key-interval",
+                    mean, std::sqrt(qMax(0.0, sumSquares / jitter.size() - mean * mean)), JitterDelayMs);
+    }
+
+    // The same upper case paste with Shift per character and held across
+    // runs, first to last event at the daemon
+    for (bool coalesce : {false, true}) {
+        TypingOptions options = unpaced;
+        options.coalesceModifiers = coalesce;
+        daemon.clear();
+        emulator.typeText(uppercaseText(UppercaseChars), UppercaseChars, options);
+        if (!waitForPaste(emulator, 60000)) {
+            return 1;
+        }
+        daemon.waitForQuiet(50);
+        const QVector<MockYdotoold::Record> records = daemon.records();
+        if (records.size() > 1) {
+            std::printf("%-28s %lld events in %.2f ms\n",
+                        coalesce ? "uppercase-coalesced" : "uppercase-per-char",
+                        static_cast<long long>(records.size()),
+                        (records.last().timestampNs - records.first().timestampNs) / NsPerMs);
+        }
+    }
+
+    // From cancel() until the last event, including the key releases
+    daemon.clear();
+    emulator.typeText(sampleText(ThroughputChars), ThroughputChars, paced);
+    if (!daemon.waitForCount(40, 5000)) {
+        std::fprintf(stderr, "Paste did not start\n");
+        return 1;
+    }
+    const qint64 cancelledAt = Pacer::now();
+    emulator.cancel();
+    if (!waitForPaste(emulator, 5000)) {
+        return 1;
+    }
+    daemon.waitForQuiet(100);
+    const QVector<MockYdotoold::Record> tail = daemon.records();
+    std::printf("%-28s %.1f us\n", "cancel-to-last-event",
+                (tail.last().timestampNs - cancelledAt) / NsPerUs);
+
+    return 0;
+}
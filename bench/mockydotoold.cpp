@@ -0,0 +1,185 @@
+#include "mockydotoold.h"
+#include "pacer.h"
+
+#include <QFile>
+#include <QMutexLocker>
+#include <QThread>
+
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+// recvmmsg() batch size; events in one batch share a timestamp
+constexpr int BatchSize = 64;
+}
+
+MockYdotoold::MockYdotoold()
+    : m_fd(-1)
+    , m_wakeFd(-1)
+    , m_thread(nullptr)
+    , m_lastReceiveNs(0)
+{
+}
+
+MockYdotoold::~MockYdotoold()
+{
+    stop();
+}
+
+bool MockYdotoold::start(const QString& socketPath)
+{
+    if (m_thread) {
+        return true;
+    }
+
+    const QByteArray path = QFile::encodeName(socketPath);
+
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= static_cast<int>(sizeof(addr.sun_path))) {
+        m_errorString = QStringLiteral("Socket path is too long: %1").arg(socketPath);
+        return false;
+    }
+    std::memcpy(addr.sun_path, path.constData(), path.size());
+
+    ::unlink(path.constData());
+    m_fd = ::socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (m_fd < 0 || ::bind(m_fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0) {
+        m_errorString = QStringLiteral("Could not bind %1: %2")
+                            .arg(socketPath, QString::fromLocal8Bit(strerror(errno)));
+        stop();
+        return false;
+    }
+
+    m_wakeFd = ::eventfd(0, EFD_CLOEXEC);
+    if (m_wakeFd < 0) {
+        m_errorString = QStringLiteral("Could not create eventfd: %1").arg(QString::fromLocal8Bit(strerror(errno)));
+        stop();
+        return false;
+    }
+
+    m_socketPath = socketPath;
+    m_thread = QThread::create([this]() {
+        receiveLoop();
+    });
+    m_thread->setObjectName(QStringLiteral("MockYdotoold"));
+    m_thread->start();
+    return true;
+}
+
+void MockYdotoold::stop()
+{
+    if (m_thread) {
+        const quint64 one = 1;
+        if (::write(m_wakeFd, &one, sizeof(one)) < 0) {
+            qWarning("MockYdotoold: could not wake the receiver");
+        }
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+
+    for (int* fd : {&m_fd, &m_wakeFd}) {
+        if (*fd >= 0) {
+            ::close(*fd);
+            *fd = -1;
+        }
+    }
+
+    if (!m_socketPath.isEmpty()) {
+        ::unlink(QFile::encodeName(m_socketPath).constData());
+        m_socketPath.clear();
+    }
+}
+
+QVector<MockYdotoold::Record> MockYdotoold::records() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_records;
+}
+
+qsizetype MockYdotoold::count() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_records.size();
+}
+
+void MockYdotoold::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_records.clear();
+}
+
+bool MockYdotoold::waitForCount(qsizetype count, int timeoutMs) const
+{
+    const qint64 deadline = Pacer::now() + qint64(timeoutMs) * 1000000;
+    while (this->count() < count) {
+        if (Pacer::now() >= deadline) {
+            return false;
+        }
+        QThread::usleep(200);
+    }
+    return true;
+}
+
+void MockYdotoold::waitForQuiet(int quietMs) const
+{
+    const qint64 quietNs = qint64(quietMs) * 1000000;
+    while (Pacer::now() - m_lastReceiveNs.load() < quietNs) {
+        QThread::usleep(500);
+    }
+}
+
+void MockYdotoold::receiveLoop()
+{
+    input_event events[BatchSize];
+    mmsghdr messages[BatchSize];
+    iovec vectors[BatchSize];
+
+    pollfd fds[2] = {
+        {m_fd, POLLIN, 0},
+        {m_wakeFd, POLLIN, 0},
+    };
+
+    for (;;) {
+        if (::poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        if (fds[1].revents) {
+            return;
+        }
+
+        std::memset(messages, 0, sizeof(messages));
+        for (int i = 0; i < BatchSize; ++i) {
+            vectors[i].iov_base = &events[i];
+            vectors[i].iov_len = sizeof(input_event);
+            messages[i].msg_hdr.msg_iov = &vectors[i];
+            messages[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        const int received = ::recvmmsg(m_fd, messages, BatchSize, MSG_DONTWAIT, nullptr);
+        if (received <= 0) {
+            continue;
+        }
+
+        const qint64 now = Pacer::now();
+        m_lastReceiveNs = now;
+
+        QMutexLocker locker(&m_mutex);
+        for (int i = 0; i < received; ++i) {
+            // ydotoold ignores short datagrams, so do we
+            if (messages[i].msg_len == sizeof(input_event)) {
+                m_records.append({now, events[i]});
+            }
+        }
+    }
+}
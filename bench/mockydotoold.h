@@ -0,0 +1,60 @@
+#ifndef MOCKYDOTOOLD_H
+#define MOCKYDOTOOLD_H
+
+#include <QMutex>
+#include <QString>
+#include <QVector>
+#include <atomic>
+
+#include <linux/input.h>
+
+class QThread;
+
+// Stand-in for ydotoold: binds a datagram socket, accepts one input_event
+// per datagram like the real daemon, and records each event with the
+// CLOCK_MONOTONIC time it was received instead of injecting it.
+class MockYdotoold
+{
+public:
+    struct Record
+    {
+        qint64 timestampNs;
+        input_event event;
+    };
+
+    MockYdotoold();
+    ~MockYdotoold();
+
+    MockYdotoold(const MockYdotoold&) = delete;
+    MockYdotoold& operator=(const MockYdotoold&) = delete;
+
+    bool start(const QString& socketPath);
+    void stop();
+    QString errorString() const { return m_errorString; }
+
+    // Thread-safe snapshot of everything received since the last clear()
+    QVector<Record> records() const;
+    qsizetype count() const;
+    void clear();
+
+    // Waits until at least count events arrived or timeoutMs passed
+    bool waitForCount(qsizetype count, int timeoutMs) const;
+
+    // Waits until nothing arrived for quietMs
+    void waitForQuiet(int quietMs) const;
+
+private:
+    void receiveLoop();
+
+    QString m_socketPath;
+    QString m_errorString;
+    int m_fd;
+    int m_wakeFd;
+    QThread* m_thread;
+
+    mutable QMutex m_mutex;
+    QVector<Record> m_records;
+    std::atomic<qint64> m_lastReceiveNs;
+};
+
+#endif // MOCKYDOTOOLD_H
@@ -0,0 +1,42 @@
+#ifndef NULLBACKEND_H
+#define NULLBACKEND_H
+
+#include "inputbackend.h"
+
+// Accepts and discards events, so the rest of the pipeline can be timed
+// without a kernel or daemon on the other end
+class NullBackend : public InputBackend
+{
+public:
+    QString name() const override { return QStringLiteral("null"); }
+
+    bool open() override
+    {
+        m_open = true;
+        return true;
+    }
+    void close() override { m_open = false; }
+    bool isOpen() const override { return m_open; }
+
+    bool writeEvents(const input_event* events, int count) override
+    {
+        // Touch the data so the writes cannot be optimized away
+        if (count > 0) {
+            m_checksum += events[count - 1].code;
+        }
+        m_events += count;
+        ++m_writes;
+        return true;
+    }
+
+    qint64 events() const { return m_events; }
+    qint64 writes() const { return m_writes; }
+
+private:
+    bool m_open = false;
+    qint64 m_events = 0;
+    qint64 m_writes = 0;
+    quint64 m_checksum = 0;
+};
+
+#endif // NULLBACKEND_H
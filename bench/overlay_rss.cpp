@@ -0,0 +1,104 @@
+// Resident memory of the targeting overlay on a simulated three-monitor
+// 4K workstation: before first use, while targeting, while pooled after
+// targeting, and after the idle teardown. Runs on the offscreen platform,
+// so it needs no display.
+
+#include "targetoverlay.h"
+
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTemporaryFile>
+#include <cstdio>
+
+namespace {
+
+constexpr int ScreenCount = 3;
+constexpr int ScreenWidth = 3840;
+constexpr int ScreenHeight = 2160;
+constexpr int IdleTimeoutMs = 200;
+
+qint64 residentKiB()
+{
+    QFile status(QStringLiteral("/proc/self/status"));
+    if (!status.open(QIODevice::ReadOnly)) {
+        return -1;
+    }
+    while (!status.atEnd()) {
+        const QByteArray line = status.readLine();
+        if (line.startsWith("VmRSS:")) {
+            return line.mid(6).trimmed().split(' ').first().toLongLong();
+        }
+    }
+    return -1;
+}
+
+// Lets the overlays map, paint and settle
+void settle(int msec)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (timer.elapsed() < msec) {
+        QApplication::processEvents(QEventLoop::AllEvents, 10);
+    }
+}
+
+void report(const char* phase, qint64 kib, qint64 baseline, int overlays)
+{
+    std::printf("%-26s %8lld KiB  %+8lld KiB  overlays %d\n", phase,
+                static_cast<long long>(kib), static_cast<long long>(kib - baseline), overlays);
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    // Offscreen platform with three 4K screens side by side
+    QTemporaryFile config;
+    if (!config.open()) {
+        std::fprintf(stderr, "Could not create the screen configuration\n");
+        return 1;
+    }
+    QByteArray screens = "{ \"screens\": [";
+    for (int i = 0; i < ScreenCount; ++i) {
+        screens += QByteArray(i > 0 ? "," : "")
+            + "{ \"name\": \"bench-" + QByteArray::number(i) + "\""
+            + ", \"x\": " + QByteArray::number(i * ScreenWidth) + ", \"y\": 0"
+            + ", \"width\": " + QByteArray::number(ScreenWidth)
+            + ", \"height\": " + QByteArray::number(ScreenHeight) + " }";
+    }
+    screens += "] }";
+    config.write(screens);
+    config.flush();
+    qputenv("QT_QPA_PLATFORM", "offscreen:configfile=" + QFile::encodeName(config.fileName()));
+
+    QApplication app(argc, argv);
+    settle(100);
+
+    const qint64 baseline = residentKiB();
+    std::printf("%d screens of %dx%d\n\n", int(QGuiApplication::screens().size()), ScreenWidth, ScreenHeight);
+    std::printf("%-26s %12s  %12s\n", "phase", "VmRSS", "vs. start");
+    report("startup", baseline, baseline, 0);
+
+    TargetOverlay overlay;
+    overlay.setIdleTimeout(IdleTimeoutMs);
+    report("constructed (idle)", residentKiB(), baseline, overlay.overlayCount());
+
+    overlay.activate();
+    settle(300);
+    report("targeting", residentKiB(), baseline, overlay.overlayCount());
+
+    overlay.deactivate();
+    settle(50);
+    report("pooled after targeting", residentKiB(), baseline, overlay.overlayCount());
+
+    settle(IdleTimeoutMs + 200);
+    report("after idle teardown", residentKiB(), baseline, overlay.overlayCount());
+
+    overlay.activate();
+    settle(300);
+    report("targeting again", residentKiB(), baseline, overlay.overlayCount());
+    overlay.deactivate();
+
+    return 0;
+}
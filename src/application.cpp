@@ -4,8 +4,12 @@
 #include "inputemulator.h"
 #include "targetoverlay.h"
 #include "clipboardmanager.h"
+#include "commandserver.h"
+#include "pacer.h"
+#include "pastemetrics.h"
 #include "settingsdialog.h"
 #include "settings.h"
+#include "textnormalizer.h"
 
 #include <QApplication>
 #include <QLockFile>
@@ -15,11 +19,18 @@
 #include <QTimer>
 #include <QDebug>
 #include <QAction>
+#include <QDBusConnection>
+#include <QFileDialog>
 #include <KGlobalAccel>
 
 Application::Application(QObject* parent)
     : QObject(parent)
     , m_cancelAction(nullptr)
+    , m_waitingForClipboard(false)
+    , m_pendingSlot(0)
+    , m_pasteRequestedNs(0)
+    , m_clipboardFetchNs(0)
+    , m_startDelayNs(0)
 {
 }
 
@@ -37,24 +48,58 @@ bool Application::initialize()
         return false;
     }
 
-    // Create components
+    // The tray icon goes up first. Everything else is set up once the event
+    // loop runs, so login is not held up by backend discovery.
     m_trayIcon = std::make_unique<TrayIcon>();
-    m_hotkeyManager = std::make_unique<HotkeyManager>();
-    m_inputEmulator = std::make_unique<InputEmulator>();
-    m_targetOverlay = std::make_unique<TargetOverlay>();
-    m_clipboardManager = std::make_unique<ClipboardManager>();
 
     // Connect tray icon signals
     connect(m_trayIcon.get(), &TrayIcon::activated,
             this, &Application::onTrayActivated);
     connect(m_trayIcon.get(), &TrayIcon::settingsRequested,
             this, &Application::onSettingsRequested);
+    connect(m_trayIcon.get(), &TrayIcon::statisticsRequested,
+            this, &Application::onStatisticsRequested);
     connect(m_trayIcon.get(), &TrayIcon::exitRequested,
             this, &Application::onExitRequested);
+    connect(m_trayIcon.get(), &TrayIcon::pauseRequested,
+            this, &Application::onPauseRequested);
+    connect(m_trayIcon.get(), &TrayIcon::resumeRequested,
+            this, &Application::onResumeRequested);
+    connect(m_trayIcon.get(), &TrayIcon::cancelRequested,
+            this, &Application::onCancelRequested);
+    connect(m_trayIcon.get(), &TrayIcon::continueRequested,
+            this, &Application::onContinueRequested);
+    connect(m_trayIcon.get(), &TrayIcon::typeFileRequested,
+            this, &Application::onTypeFileRequested);
+
+    // Show tray icon
+    m_trayIcon->show();
+
+    QTimer::singleShot(0, this, &Application::initializeComponents);
+
+    return true;
+}
+
+void Application::initializeComponents()
+{
+    // Create components; the target overlay is created on first use
+    m_hotkeyManager = std::make_unique<HotkeyManager>();
+    m_inputEmulator = std::make_unique<InputEmulator>();
+    m_clipboardManager = std::make_unique<ClipboardManager>();
+    m_metrics = std::make_unique<PasteMetrics>();
+    m_commandServer = std::make_unique<CommandServer>();
+
+    // Paste statistics for tuning, e.g. qdbus app.clickpaste.ClickPaste /Metrics summaryText
+    QDBusConnection bus = QDBusConnection::sessionBus();
+    if (!bus.registerService(QStringLiteral("app.clickpaste.ClickPaste")) || !m_metrics->registerOn(bus)) {
+        qWarning() << "Could not export paste statistics on the session bus";
+    }
 
     // Connect hotkey manager signals
     connect(m_hotkeyManager.get(), &HotkeyManager::hotkeyTriggered,
             this, &Application::onHotkeyTriggered);
+    connect(m_hotkeyManager.get(), &HotkeyManager::slotTriggered,
+            this, &Application::onSlotTriggered);
     connect(m_hotkeyManager.get(), &HotkeyManager::registrationFailed,
             this, [this](const QString& reason) {
                 m_trayIcon->showMessage(QStringLiteral("ClickPaste"),
@@ -62,47 +107,86 @@ bool Application::initialize()
                                         QSystemTrayIcon::Warning);
             });
 
-    // Connect target overlay signals
-    connect(m_targetOverlay.get(), &TargetOverlay::targetSelected,
-            this, &Application::onTargetSelected);
-    connect(m_targetOverlay.get(), &TargetOverlay::cancelled,
-            this, &Application::onTargetCancelled);
-
     // Connect input emulator signals
+    connect(m_inputEmulator.get(), &InputEmulator::initialized, this, [this](bool ok) {
+        // A paste asked for during discovery is already under way
+        if (m_commandServer->state() == CommandServer::Starting) {
+            m_commandServer->setState(CommandServer::Idle);
+        }
+        if (!ok) {
+            qWarning() << "Failed to initialize input emulator - typing may not work";
+            m_trayIcon->showMessage(QStringLiteral("ClickPaste"),
+                                    QStringLiteral("Failed to initialize input emulation. "
+                                                  "Add yourself to the 'input' group for /dev/uinput "
+                                                  "(sudo usermod -aG input $USER, then log in again), "
+                                                  "or enable ydotoold (sudo systemctl enable --now ydotoold.service)."),
+                                    QSystemTrayIcon::Warning);
+        }
+    });
     connect(m_inputEmulator.get(), &InputEmulator::typingStarted,
             this, &Application::onTypingStarted);
+    connect(m_inputEmulator.get(), &InputEmulator::typingPlanned,
+            this, &Application::onTypingPlanned);
+    connect(m_inputEmulator.get(), &InputEmulator::typingProgress,
+            this, &Application::onTypingProgress);
+    connect(m_inputEmulator.get(), &InputEmulator::typingPaused,
+            this, &Application::onTypingPaused);
+    connect(m_inputEmulator.get(), &InputEmulator::typingResumed,
+            this, &Application::onTypingResumed);
     connect(m_inputEmulator.get(), &InputEmulator::typingFinished,
             this, &Application::onTypingFinished);
     connect(m_inputEmulator.get(), &InputEmulator::typingCancelled,
             this, &Application::onTypingCancelled);
     connect(m_inputEmulator.get(), &InputEmulator::errorOccurred,
             this, &Application::onTypingError);
+    connect(m_inputEmulator.get(), &InputEmulator::sessionFinished,
+            this, &Application::onSessionFinished);
 
     // Connect settings changes
     connect(Settings::instance(), &Settings::hotkeyChanged,
             this, &Application::onHotkeyChanged);
+    connect(Settings::instance(), &Settings::settingsChanged,
+            this, &Application::onSettingsChanged);
+    m_clipboardManager->setHistoryMemoryLimit(qsizetype(Settings::instance()->snapshot()->historyMemoryKiB) * 1024);
 
-    // Initialize input emulator
-    if (!m_inputEmulator->initialize()) {
-        qWarning() << "Failed to initialize input emulator - typing may not work";
-        m_trayIcon->showMessage(QStringLiteral("ClickPaste"),
-                                QStringLiteral("Failed to initialize input emulation. "
-                                              "Ensure your compositor supports libei."),
-                                QSystemTrayIcon::Warning);
-    }
+    // Find an input backend in the background, it may have to start ydotoold
+    m_inputEmulator->initialize();
 
-    // Register hotkey
+    // Register hotkeys
     registerHotkey();
+    registerSlotHotkeys();
+
+    // Commands from later launches, e.g. clickpaste --type-text, once
+    // everything they need is there
+    connect(m_commandServer.get(), &CommandServer::typeTextRequested,
+            this, &Application::typeText);
+    connect(m_commandServer.get(), &CommandServer::typeFileRequested,
+            this, &Application::typeFile);
+    connect(m_commandServer.get(), &CommandServer::cancelRequested,
+            this, &Application::onCancelRequested);
+    if (!m_commandServer->listen()) {
+        qWarning() << "Could not listen for commands:" << m_commandServer->errorString();
+    }
+}
 
-    // Show tray icon
-    m_trayIcon->show();
-
-    return true;
+TargetOverlay* Application::targetOverlay()
+{
+    if (!m_targetOverlay) {
+        m_targetOverlay = std::make_unique<TargetOverlay>();
+
+        // Connect target overlay signals
+        connect(m_targetOverlay.get(), &TargetOverlay::targetSelected,
+                this, &Application::onTargetSelected);
+        connect(m_targetOverlay.get(), &TargetOverlay::cancelled,
+                this, &Application::onTargetCancelled);
+    }
+    return m_targetOverlay.get();
 }
 
 void Application::shutdown()
 {
     if (m_hotkeyManager) {
+        m_hotkeyManager->unregisterSlotHotkeys();
         m_hotkeyManager->unregisterHotkey();
     }
 
@@ -140,6 +224,7 @@ bool Application::checkSingleInstance()
 void Application::onTrayActivated()
 {
     // Tray icon clicked - start targeting
+    m_pendingSlot = 0;
     startTargeting();
 }
 
@@ -155,17 +240,108 @@ void Application::onSettingsRequested()
     m_hotkeyManager->setEnabled(true);
 }
 
+void Application::onStatisticsRequested()
+{
+    QMessageBox::information(nullptr, QStringLiteral("ClickPaste - Statistics"),
+                             m_metrics->summaryText());
+}
+
 void Application::onExitRequested()
 {
     shutdown();
     QApplication::quit();
 }
 
+void Application::onPauseRequested()
+{
+    if (m_inputEmulator) {
+        m_inputEmulator->pause();
+    }
+}
+
+void Application::onResumeRequested()
+{
+    if (m_inputEmulator) {
+        m_inputEmulator->resume();
+    }
+}
+
+void Application::onCancelRequested()
+{
+    if (m_inputEmulator && m_inputEmulator->isTyping()) {
+        m_inputEmulator->cancel();
+    }
+}
+
+void Application::onContinueRequested()
+{
+    if (!canContinue()) {
+        return;
+    }
+
+    m_pendingSlot = ResumeSlot;
+    if (Settings::instance()->snapshot()->hotkeyMode == Settings::JustGo) {
+        startTyping();
+    } else {
+        startTargeting();
+    }
+}
+
+void Application::onTypeFileRequested()
+{
+    const QString path = QFileDialog::getOpenFileName(nullptr, QStringLiteral("ClickPaste - Type File"));
+    if (path.isEmpty()) {
+        return;
+    }
+
+    m_pendingFile = path;
+    m_pendingSlot = FileSlot;
+    if (Settings::instance()->snapshot()->hotkeyMode == Settings::JustGo) {
+        startTyping();
+    } else {
+        startTargeting();
+    }
+}
+
+void Application::typeFile(const QString& path)
+{
+    m_pendingFile = path;
+    m_pendingSlot = FileSlot;
+    startTyping();
+}
+
+void Application::typeText(const QByteArray& text)
+{
+    if (m_inputEmulator->isTyping()) {
+        return;
+    }
+
+    m_pasteRequestedNs = Pacer::now();
+    m_clipboardFetchNs = 0;
+    TextNormalizer::Stats stats;
+    QByteArray normalized = TextNormalizer::normalized(text, &stats);
+    if (!stats.valid) {
+        // As for the clipboard: bad sequences become U+FFFD, which types
+        // like any other character, instead of reaching the encoder
+        qWarning() << "Text to type is not valid UTF-8";
+        normalized = TextNormalizer::normalized(QString::fromUtf8(text).toUtf8(), &stats);
+    }
+    if (normalized.isEmpty()) {
+        return;
+    }
+    beginPaste(normalized, stats.characters, typingOptions(*Settings::instance()->snapshot()));
+}
+
 void Application::onHotkeyTriggered()
 {
-    Settings* s = Settings::instance();
+    onSlotTriggered(1);
+}
+
+void Application::onSlotTriggered(int slot)
+{
+    m_pendingSlot = slot - 1;
 
-    if (s->hotkeyMode() == Settings::JustGo) {
+    if (Settings::instance()->snapshot()->hotkeyMode == Settings::JustGo) {
         // Just Go mode - type immediately to focused window
         startTyping();
     } else {
@@ -181,7 +357,7 @@ void Application::startTargeting()
     }
 
     m_trayIcon->setIconState(TrayIcon::Targeting);
-    m_targetOverlay->activate();
+    targetOverlay()->activate();
 }
 
 void Application::onTargetSelected(const QPoint& globalPos)
@@ -201,43 +377,154 @@ void Application::onTargetCancelled()
 
 void Application::startTyping()
 {
-    // Check clipboard
-    if (!m_clipboardManager->hasText()) {
+    if (m_pendingSlot == ResumeSlot) {
+        continuePaste();
+        return;
+    }
+
+    // Files never go through the clipboard; the worker reads them itself
+    if (m_pendingSlot == FileSlot) {
+        if (m_inputEmulator->isTyping()) {
+            return;
+        }
+        m_pasteRequestedNs = Pacer::now();
+        m_clipboardFetchNs = 0;
+        m_session = PasteProgress();
+        m_session.file = m_pendingFile;
+        m_resume = PasteProgress();
+        m_trayIcon->setContinueAvailable(0);
+        const TypingOptions options = typingOptions(*Settings::instance()->snapshot());
+        m_startDelayNs = qint64(options.startDelayMs) * 1000000;
+        m_commandServer->setState(CommandServer::Typing);
+        m_commandServer->setProgress(0, 0);
+        m_inputEmulator->typeFile(m_pendingFile, options);
+        return;
+    }
+
+    if (!m_waitingForClipboard) {
+        m_pasteRequestedNs = Pacer::now();
+    }
+
+    // A large clipboard may still be transferring; type once it is complete
+    if (!m_clipboardManager->ensureCurrent()) {
+        if (!m_waitingForClipboard) {
+            m_waitingForClipboard = true;
+            connect(m_clipboardManager.get(), &ClipboardManager::readFinished, this, [this](bool ok) {
+                m_waitingForClipboard = false;
+                if (!ok) {
+                    qWarning() << "Clipboard read failed, typing the last text read";
+                }
+                startTyping();
+            }, Qt::SingleShotConnection);
+        }
+        return;
+    }
+
+    // Check clipboard, or the history entry asked for
+    QByteArray text;
+    qsizetype characters = 0;
+    qsizetype lines = 0;
+    if (m_pendingSlot == 0) {
+        text = m_clipboardManager->getText();
+        characters = m_clipboardManager->characterCount();
+        lines = m_clipboardManager->lineCount();
+    } else {
+        const ClipboardHistory& history = m_clipboardManager->history();
+        if (m_pendingSlot < history.count()) {
+            text = history.text(m_pendingSlot);
+            characters = history.characterCount(m_pendingSlot);
+            lines = history.lineCount(m_pendingSlot);
+        }
+    }
+    m_clipboardFetchNs = Pacer::now() - m_pasteRequestedNs;
+    if (text.isEmpty()) {
         QApplication::beep();
         m_trayIcon->showMessage(QStringLiteral("ClickPaste"),
-                                QStringLiteral("Clipboard is empty"),
+                                m_pendingSlot == 0
+                                    ? QStringLiteral("Clipboard is empty")
+                                    : QStringLiteral("History entry %1 is empty").arg(m_pendingSlot + 1),
                                 QSystemTrayIcon::Information);
         return;
     }
 
-    QString text = m_clipboardManager->getText();
+    // One consistent view of the settings for the whole paste
+    const Settings::SnapshotPtr s = Settings::instance()->snapshot();
 
     // Check confirmation
-    Settings* s = Settings::instance();
-    if (s->confirmEnabled() && text.length() > s->confirmThreshold()) {
-        if (!showConfirmationDialog(text)) {
+    if (s->confirmEnabled && characters > s->confirmThreshold) {
+        if (!showConfirmationDialog(text, characters, lines)) {
             return;
         }
     }
 
-    // Start typing
-    m_inputEmulator->typeText(text, s->keyDelayMs(), s->startDelayMs());
+    beginPaste(text, characters, typingOptions(*s));
+}
+
+void Application::beginPaste(const QByteArray& text, qsizetype characters, const TypingOptions& options)
+{
+    // A new paste replaces whatever was left to continue
+    m_session = PasteProgress();
+    m_session.text = text;
+    m_session.total = static_cast<int>(characters);
+    m_resume = PasteProgress();
+    m_trayIcon->setContinueAvailable(0);
+
+    m_startDelayNs = qint64(options.startDelayMs) * 1000000;
+
+    // Busy for the command server from here, not from typingStarted(),
+    // so a second request cannot slip in while this one is queued
+    m_commandServer->setState(CommandServer::Typing);
+    m_commandServer->setProgress(0, m_session.total);
+    m_inputEmulator->typeText(text, m_session.total, options);
+}
+
+bool Application::canContinue() const
+{
+    return !m_resume.text.isEmpty() || !m_resume.file.isEmpty();
+}
+
+void Application::continuePaste()
+{
+    if (m_inputEmulator->isTyping() || !canContinue()) {
+        return;
+    }
+
+    m_pasteRequestedNs = Pacer::now();
+    m_clipboardFetchNs = 0;
+
+    // Picks up at the first character that was not typed
+    m_session = m_resume;
+    m_resume = PasteProgress();
+    m_trayIcon->setContinueAvailable(0);
+
+    const TypingOptions options = typingOptions(*Settings::instance()->snapshot());
+    m_startDelayNs = qint64(options.startDelayMs) * 1000000;
+    m_commandServer->setState(CommandServer::Typing);
+    m_commandServer->setProgress(m_session.typed, m_session.total);
+    if (!m_session.file.isEmpty()) {
+        m_inputEmulator->typeFile(m_session.file, options, m_session.offset);
+        return;
+    }
+    m_inputEmulator->typeText(m_session.text.sliced(m_session.offset),
+                              m_session.total - m_session.typed, options);
 }
 
-bool Application::showConfirmationDialog(const QString& text)
+bool Application::showConfirmationDialog(const QByteArray& text, qsizetype characters, qsizetype lines)
 {
     QApplication::beep();
 
-    QString preview = text.left(100);
-    if (text.length() > 100) {
+    // Only decode what the preview shows; 4 bytes cover any character
+    QString preview = QString::fromUtf8(text.left(400)).left(100);
+    if (characters > 100) {
         preview += QStringLiteral("...");
     }
 
     QMessageBox::StandardButton result = QMessageBox::question(
         nullptr,
         QStringLiteral("ClickPaste - Confirm"),
-        QStringLiteral("About to type %1 characters:\n\n\"%2\"\n\nContinue?")
-            .arg(text.length())
+        QStringLiteral("About to type %1 characters on %2 lines:\n\n\"%3\"\n\nContinue?")
+            .arg(characters)
+            .arg(lines + 1)
             .arg(preview),
         QMessageBox::Yes | QMessageBox::No,
         QMessageBox::Yes
@@ -248,30 +535,102 @@ bool Application::showConfirmationDialog(const QString& text)
 
 void Application::onTypingStarted()
 {
+    m_commandServer->setState(CommandServer::Typing);
+    m_commandServer->setProgress(m_session.typed, m_session.total);
     m_trayIcon->setIconState(TrayIcon::Typing);
     m_hotkeyManager->setEnabled(false);
     registerCancelHotkey();
 }
 
+void Application::onTypingPlanned(int slowPath, int skipped)
+{
+    if (skipped > 0) {
+        m_trayIcon->showMessage(QStringLiteral("ClickPaste"),
+                                QStringLiteral("%1 characters have no key on the keyboard layout and will be skipped. "
+                                               "Settings can enable Ctrl+Shift+U or Compose input for them.")
+                                    .arg(skipped),
+                                QSystemTrayIcon::Warning);
+    } else if (slowPath > 0) {
+        m_trayIcon->showMessage(QStringLiteral("ClickPaste"),
+                                QStringLiteral("%1 characters will be typed as Compose or Unicode sequences")
+                                    .arg(slowPath),
+                                QSystemTrayIcon::Information);
+    }
+}
+
+void Application::onTypingProgress(int current, int total)
+{
+    // A file's length in characters is only known once it was planned
+    if (!m_session.file.isEmpty()) {
+        m_session.total = m_session.typed + total;
+    }
+    // Counted from the start of the text when continuing a paste
+    m_commandServer->setProgress(m_session.typed + current, m_session.typed + total);
+    m_trayIcon->setProgress(m_session.typed + current, m_session.typed + total);
+}
+
+void Application::onTypingPaused(int current, int total)
+{
+    // Escape belongs to the target window while we are paused
+    unregisterCancelHotkey();
+    m_commandServer->setState(CommandServer::Paused);
+    m_commandServer->setProgress(m_session.typed + current, m_session.typed + total);
+    m_trayIcon->setIconState(TrayIcon::Paused);
+    m_trayIcon->setProgress(m_session.typed + current, m_session.typed + total);
+}
+
+void Application::onTypingResumed()
+{
+    m_commandServer->setState(CommandServer::Typing);
+    m_trayIcon->setIconState(TrayIcon::Typing);
+    registerCancelHotkey();
+}
+
 void Application::onTypingFinished()
 {
+    m_commandServer->setState(CommandServer::Idle);
+    m_session = PasteProgress();
     unregisterCancelHotkey();
     m_trayIcon->setIconState(TrayIcon::Normal);
     m_hotkeyManager->setEnabled(true);
 }
 
-void Application::onTypingCancelled()
+void Application::onTypingCancelled(qsizetype offset, int typed)
 {
+    m_commandServer->setState(CommandServer::Idle);
     unregisterCancelHotkey();
     m_trayIcon->setIconState(TrayIcon::Normal);
     m_hotkeyManager->setEnabled(true);
+
+    // Keep the rest so it can be typed later without starting over
+    m_resume = m_session;
+    m_resume.offset += offset;
+    m_resume.typed += typed;
+    m_session = PasteProgress();
+    // A file cancelled before its first key is simply typed again
+    const bool done = m_resume.file.isEmpty()
+        ? m_resume.offset >= m_resume.text.size()
+        : m_resume.typed == 0 || m_resume.typed >= m_resume.total;
+    if (done) {
+        m_resume = PasteProgress();
+    }
+
+    const int remaining = canContinue() ? m_resume.total - m_resume.typed : 0;
+    m_trayIcon->setContinueAvailable(remaining);
     m_trayIcon->showMessage(QStringLiteral("ClickPaste"),
-                            QStringLiteral("Typing cancelled"),
+                            remaining > 0
+                                ? QStringLiteral("Typing cancelled after %1 of %2 characters")
+                                      .arg(m_resume.typed).arg(m_resume.total)
+                                : QStringLiteral("Typing cancelled"),
                             QSystemTrayIcon::Information);
 }
 
 void Application::onTypingError(const QString& error)
 {
+    // Reaches the client when the paste fails before its request is answered
+    m_commandServer->refuse(error);
+    m_commandServer->setState(CommandServer::Idle);
+    m_session = PasteProgress();
     unregisterCancelHotkey();
     m_trayIcon->setIconState(TrayIcon::Normal);
     m_hotkeyManager->setEnabled(true);
@@ -280,15 +639,46 @@ void Application::onTypingError(const QString& error)
                             QSystemTrayIcon::Critical);
 }
 
+void Application::onSessionFinished(const PasteReport& report)
+{
+    PasteReport complete = report;
+    complete.requestedNs = m_pasteRequestedNs;
+    complete.clipboardFetchNs = m_clipboardFetchNs;
+    complete.startDelayNs = m_startDelayNs;
+    m_metrics->recordSession(complete);
+}
+
 void Application::onHotkeyChanged()
 {
     registerHotkey();
+    registerSlotHotkeys();
+}
+
+void Application::onSettingsChanged()
+{
+    const Settings::SnapshotPtr s = Settings::instance()->snapshot();
+    m_clipboardManager->setHistoryMemoryLimit(qsizetype(s->historyMemoryKiB) * 1024);
+
+    // Only touch KGlobalAccel when the setting actually flipped
+    if (s->historyHotkeysEnabled != m_hotkeyManager->hasSlotHotkeys()) {
+        registerSlotHotkeys();
+    }
 }
 
 void Application::registerHotkey()
 {
-    Settings* s = Settings::instance();
-    m_hotkeyManager->registerHotkey(s->hotkey(), s->hotkeyModifiers());
+    const Settings::SnapshotPtr s = Settings::instance()->snapshot();
+    m_hotkeyManager->registerHotkey(s->hotkey, s->hotkeyModifiers);
+}
+
+void Application::registerSlotHotkeys()
+{
+    const Settings::SnapshotPtr s = Settings::instance()->snapshot();
+    if (s->historyHotkeysEnabled) {
+        m_hotkeyManager->registerSlotHotkeys(ClipboardHistory::MaxEntries, s->hotkeyModifiers);
+    } else {
+        m_hotkeyManager->unregisterSlotHotkeys();
+    }
 }
 
 void Application::registerCancelHotkey()
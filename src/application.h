@@ -1,7 +1,12 @@
 #ifndef APPLICATION_H
 #define APPLICATION_H
 
+#include "pastereport.h"
+#include "typingoptions.h"
+
+#include <QByteArray>
 #include <QObject>
+#include <QString>
 #include <memory>
 
 class QAction;
@@ -10,7 +15,9 @@ class HotkeyManager;
 class InputEmulator;
 class TargetOverlay;
 class ClipboardManager;
+class PasteMetrics;
 class SettingsDialog;
+class CommandServer;
 class QLockFile;
 
 class Application : public QObject
@@ -24,29 +31,70 @@ public:
     bool initialize();
     void shutdown();
 
+    // Type into the focused window, as Just Go mode would
+    void typeFile(const QString& path);
+    // text is UTF-8 as given, it is normalized like the clipboard
+    void typeText(const QByteArray& text);
+
 private Q_SLOTS:
     void onTrayActivated();
     void onSettingsRequested();
+    void onStatisticsRequested();
     void onExitRequested();
+    void onPauseRequested();
+    void onResumeRequested();
+    void onCancelRequested();
+    void onContinueRequested();
+    void onTypeFileRequested();
 
     void onHotkeyTriggered();
+    void onSlotTriggered(int slot);
     void onTargetSelected(const QPoint& globalPos);
     void onTargetCancelled();
 
     void onTypingStarted();
+    void onTypingPlanned(int slowPath, int skipped);
+    void onTypingProgress(int current, int total);
+    void onTypingPaused(int current, int total);
+    void onTypingResumed();
     void onTypingFinished();
-    void onTypingCancelled();
+    void onTypingCancelled(qsizetype offset, int typed);
     void onTypingError(const QString& error);
+    void onSessionFinished(const PasteReport& report);
 
     void onHotkeyChanged();
+    void onSettingsChanged();
 
 private:
+    // m_pendingSlot values for continuing a cancelled paste and for
+    // typing m_pendingFile
+    static constexpr int ResumeSlot = -1;
+    static constexpr int FileSlot = -2;
+
+    // A paste and how far into it typing got. A file paste has no text;
+    // offset then counts into the file's normalized text and total is
+    // known once typing reports progress.
+    struct PasteProgress
+    {
+        QByteArray text;
+        QString file;
+        qsizetype offset = 0;
+        int typed = 0;
+        int total = 0;
+    };
+
     bool checkSingleInstance();
+    void initializeComponents();
+    TargetOverlay* targetOverlay();
     void startTargeting();
     void startTyping();
-    bool showConfirmationDialog(const QString& text);
+    void beginPaste(const QByteArray& text, qsizetype characters, const TypingOptions& options);
+    void continuePaste();
+    bool canContinue() const;
+    bool showConfirmationDialog(const QByteArray& text, qsizetype characters, qsizetype lines);
 
     void registerHotkey();
+    void registerSlotHotkeys();
     void registerCancelHotkey();
     void unregisterCancelHotkey();
 
@@ -56,7 +104,23 @@ private:
     std::unique_ptr<InputEmulator> m_inputEmulator;
     std::unique_ptr<TargetOverlay> m_targetOverlay;
     std::unique_ptr<ClipboardManager> m_clipboardManager;
+    std::unique_ptr<PasteMetrics> m_metrics;
+    std::unique_ptr<CommandServer> m_commandServer;
     QAction* m_cancelAction;
+    bool m_waitingForClipboard;
+
+    // History entry to type next, 0 is the current clipboard
+    int m_pendingSlot;
+
+    // The paste being typed, and the rest of the last cancelled one
+    PasteProgress m_session;
+    PasteProgress m_resume;
+    QString m_pendingFile;
+
+    // Timing of the current paste, for the metrics
+    qint64 m_pasteRequestedNs;
+    qint64 m_clipboardFetchNs;
+    qint64 m_startDelayNs;
 };
 
 #endif // APPLICATION_H
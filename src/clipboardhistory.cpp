@@ -0,0 +1,111 @@
+#include "clipboardhistory.h"
+
+namespace {
+// Smaller entries are not worth the zlib overhead
+constexpr qsizetype CompressThreshold = 4096;
+
+// Fast rather than small; runs on the GUI thread when text is copied
+constexpr int CompressionLevel = 1;
+
+constexpr qsizetype DefaultMemoryLimit = 4 * 1024 * 1024;
+}
+
+ClipboardHistory::ClipboardHistory()
+    : m_memoryLimit(DefaultMemoryLimit)
+    , m_memoryUsage(0)
+{
+}
+
+void ClipboardHistory::add(const QByteArray& text, const TextNormalizer::Stats& stats)
+{
+    if (text.isEmpty()) {
+        return;
+    }
+    if (!m_entries.isEmpty() && m_entries.first().data == text) {
+        return;
+    }
+
+    const size_t hash = qHash(text);
+    for (int i = 1; i < m_entries.size(); ++i) {
+        const Entry& candidate = m_entries.at(i);
+        if (candidate.hash == hash && candidate.stats.characters == stats.characters
+            && this->text(i) == text) {
+            m_memoryUsage -= m_entries.at(i).data.size();
+            m_entries.removeAt(i);
+            break;
+        }
+    }
+
+    // The previous newest entry becomes history
+    if (!m_entries.isEmpty()) {
+        Entry& previous = m_entries.first();
+        m_memoryUsage -= previous.data.size();
+        compress(previous);
+        m_memoryUsage += previous.data.size();
+    }
+
+    Entry entry;
+    entry.data = text;
+    entry.hash = hash;
+    entry.stats = stats;
+    m_entries.prepend(entry);
+    m_memoryUsage += text.size();
+
+    enforceLimits();
+}
+
+void ClipboardHistory::clear()
+{
+    m_entries.clear();
+    m_memoryUsage = 0;
+}
+
+QByteArray ClipboardHistory::text(int index) const
+{
+    if (index < 0 || index >= m_entries.size()) {
+        return QByteArray();
+    }
+
+    const Entry& entry = m_entries.at(index);
+    return entry.compressed ? qUncompress(entry.data) : entry.data;
+}
+
+qsizetype ClipboardHistory::characterCount(int index) const
+{
+    return index >= 0 && index < m_entries.size() ? m_entries.at(index).stats.characters : 0;
+}
+
+qsizetype ClipboardHistory::lineCount(int index) const
+{
+    return index >= 0 && index < m_entries.size() ? m_entries.at(index).stats.lines : 0;
+}
+
+void ClipboardHistory::setMemoryLimit(qsizetype bytes)
+{
+    m_memoryLimit = bytes;
+    enforceLimits();
+}
+
+void ClipboardHistory::compress(Entry& entry)
+{
+    if (entry.compressed || entry.data.size() < CompressThreshold) {
+        return;
+    }
+
+    QByteArray packed = qCompress(entry.data, CompressionLevel);
+    if (packed.size() < entry.data.size()) {
+        entry.data = packed;
+        entry.compressed = true;
+    }
+}
+
+void ClipboardHistory::enforceLimits()
+{
+    // Oldest entries go first; the newest one stays even if it alone is
+    // over the limit, it is the current clipboard
+    while (m_entries.size() > 1
+           && (m_entries.size() > MaxEntries || m_memoryUsage > m_memoryLimit)) {
+        m_memoryUsage -= m_entries.last().data.size();
+        m_entries.removeLast();
+    }
+}
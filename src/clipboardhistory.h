@@ -0,0 +1,51 @@
+#ifndef CLIPBOARDHISTORY_H
+#define CLIPBOARDHISTORY_H
+
+#include "textnormalizer.h"
+
+#include <QByteArray>
+#include <QHashFunctions>
+#include <QList>
+
+// Recent clipboard texts, newest first, within a memory budget. Only the
+// newest entry is kept as is, older large entries are held compressed.
+class ClipboardHistory
+{
+public:
+    static constexpr int MaxEntries = 9;
+
+    ClipboardHistory();
+
+    // Adds text as the newest entry; an existing copy moves to the front
+    void add(const QByteArray& text, const TextNormalizer::Stats& stats);
+    void clear();
+
+    int count() const { return m_entries.size(); }
+    QByteArray text(int index) const;
+    qsizetype characterCount(int index) const;
+    qsizetype lineCount(int index) const;
+
+    void setMemoryLimit(qsizetype bytes);
+    qsizetype memoryLimit() const { return m_memoryLimit; }
+    qsizetype memoryUsage() const { return m_memoryUsage; }
+
+private:
+    struct Entry
+    {
+        QByteArray data;
+        bool compressed = false;
+        // Of the uncompressed text, so duplicates are found without
+        // decompressing every entry
+        size_t hash = 0;
+        TextNormalizer::Stats stats;
+    };
+
+    void compress(Entry& entry);
+    void enforceLimits();
+
+    QList<Entry> m_entries;
+    qsizetype m_memoryLimit;
+    qsizetype m_memoryUsage;
+};
+
+#endif // CLIPBOARDHISTORY_H
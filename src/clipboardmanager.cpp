@@ -1,46 +1,327 @@
 #include "clipboardmanager.h"
+#ifdef HAVE_DATA_CONTROL
+#include "datacontrolclipboard.h"
+#endif
 
 #include <QApplication>
 #include <QClipboard>
-#include <QProcess>
+#include <QDebug>
+#include <QStandardPaths>
+#include <QTimer>
+#include <utility>
+
+namespace {
+// A transfer is given up only after this long without any new data
+constexpr int StallTimeoutMs = 3000;
+}
 
 ClipboardManager::ClipboardManager(QObject* parent)
     : QObject(parent)
     , m_clipboard(QApplication::clipboard())
+    , m_dataControl(nullptr)
+    , m_watcher(nullptr)
+    , m_reader(nullptr)
+    , m_refreshPending(false)
+    , m_reading(false)
+    , m_stale(false)
+    , m_retryPending(false)
+    , m_retrying(false)
+    , m_stallTimer(new QTimer(this))
 {
+    m_stallTimer->setSingleShot(true);
+    m_stallTimer->setInterval(StallTimeoutMs);
+    connect(m_stallTimer, &QTimer::timeout, this, &ClipboardManager::onReadStalled);
+
+#ifdef HAVE_DATA_CONTROL
+    // Read the selection ourselves if the compositor supports data-control
+    m_dataControl = new DataControlClipboard(this);
+    connect(m_dataControl, &DataControlClipboard::selectionChanged, this, &ClipboardManager::beginRead);
+    connect(m_dataControl, &DataControlClipboard::textData, this, &ClipboardManager::appendData);
+    connect(m_dataControl, &DataControlClipboard::textFinished, this, &ClipboardManager::finishRead);
+    connect(m_dataControl, &DataControlClipboard::lost, this, [this]() {
+        qWarning() << "Clipboard data-control device is gone, falling back to wl-paste";
+        m_dataControl->deleteLater();
+        m_dataControl = nullptr;
+        // A transfer cut off with the connection ends as a failed read
+        finishRead(false);
+        startFallback();
+    });
+    if (m_dataControl->start()) {
+        return;
+    }
+    delete m_dataControl;
+    m_dataControl = nullptr;
+#endif
+
+    startFallback();
 }
 
-QString ClipboardManager::getText() const
+ClipboardManager::~ClipboardManager()
 {
-    // Try wl-paste first (more reliable on Wayland)
-    QProcess process;
-    process.start(QStringLiteral("wl-paste"), {QStringLiteral("--no-newline")});
-    if (process.waitForFinished(1000)) {
-        QString text = QString::fromUtf8(process.readAllStandardOutput());
-        if (!text.isEmpty()) {
-            // Normalize line endings: \r\n -> \n (Linux standard)
-            text.replace(QStringLiteral("\r\n"), QStringLiteral("\n"));
-            text.replace(QStringLiteral("\r"), QStringLiteral("\n"));
-            return text;
+    for (QProcess* process : {m_watcher, m_reader}) {
+        if (process) {
+            process->disconnect(this);
+            process->kill();
+            process->waitForFinished(100);
         }
     }
+}
 
-    // Fallback to Qt clipboard
-    QString text = m_clipboard->text();
-    text.replace(QStringLiteral("\r\n"), QStringLiteral("\n"));
-    text.replace(QStringLiteral("\r"), QStringLiteral("\n"));
-    return text;
+QByteArray ClipboardManager::getText() const
+{
+    return m_text;
 }
 
 bool ClipboardManager::hasText() const
 {
-    // Try wl-paste first
-    QProcess process;
-    process.start(QStringLiteral("wl-paste"), {QStringLiteral("--no-newline")});
-    if (process.waitForFinished(1000)) {
-        return !process.readAllStandardOutput().isEmpty();
+    return !m_text.isEmpty();
+}
+
+qsizetype ClipboardManager::characterCount() const
+{
+    return m_stats.characters;
+}
+
+qsizetype ClipboardManager::lineCount() const
+{
+    return m_stats.lines;
+}
+
+const ClipboardHistory& ClipboardManager::history() const
+{
+    return m_history;
+}
+
+void ClipboardManager::setHistoryMemoryLimit(qsizetype bytes)
+{
+    m_history.setMemoryLimit(bytes);
+}
+
+bool ClipboardManager::ensureCurrent()
+{
+    if (m_stale && !m_reading) {
+        m_retryPending = true;
+#ifdef HAVE_DATA_CONTROL
+        if (m_dataControl) {
+            beginRead();
+            m_dataControl->readSelection();
+            return !m_reading;
+        }
+#endif
+        refresh();
+        return !m_reading;
     }
 
-    // Fallback to Qt clipboard
-    return !m_clipboard->text().isEmpty();
+    // Without change notifications the snapshot may be stale
+    if (!m_dataControl && !m_reading && !isWatching()) {
+        refresh();
+    }
+    return !m_reading;
+}
+
+bool ClipboardManager::isReading() const
+{
+    return m_reading;
+}
+
+void ClipboardManager::refresh()
+{
+    if (m_wlPaste.isEmpty()) {
+        // Qt's clipboard is all there is; nothing left to retry
+        m_stale = false;
+        m_retryPending = false;
+        setQtClipboardText();
+        return;
+    }
+
+    if (m_reader) {
+        // Read again once the current read is done
+        m_refreshPending = true;
+        return;
+    }
+
+    // wl-paste is more reliable on Wayland
+    beginRead();
+    m_reader = new QProcess(this);
+    connect(m_reader, &QProcess::readyReadStandardOutput, this, [this]() {
+        appendData(m_reader->readAllStandardOutput());
+    });
+    connect(m_reader, &QProcess::finished, this, &ClipboardManager::onReaderFinished);
+    connect(m_reader, &QProcess::errorOccurred, this, &ClipboardManager::onReaderError);
+    m_reader->start(m_wlPaste, {QStringLiteral("--no-newline")});
+}
+
+void ClipboardManager::onReaderFinished(int exitCode, QProcess::ExitStatus exitStatus)
+{
+    appendData(m_reader->readAllStandardOutput());
+
+    m_reader->deleteLater();
+    m_reader = nullptr;
+
+    finishRead(exitStatus == QProcess::NormalExit && exitCode == 0);
+
+    if (m_refreshPending) {
+        m_refreshPending = false;
+        refresh();
+    }
+}
+
+void ClipboardManager::onReaderError(QProcess::ProcessError error)
+{
+    // Other errors end in finished(), this one never does
+    if (error != QProcess::FailedToStart) {
+        return;
+    }
+
+    qWarning() << "Could not run wl-paste:" << m_reader->errorString();
+    m_reader->deleteLater();
+    m_reader = nullptr;
+
+    finishRead(false);
+
+    if (m_refreshPending) {
+        m_refreshPending = false;
+        refresh();
+    }
+}
+
+void ClipboardManager::onReadStalled()
+{
+    qWarning() << "Clipboard source stopped sending data, giving up on this read";
+
+    if (m_reader) {
+        // onReaderFinished() completes the read
+        m_reader->kill();
+        return;
+    }
+
+#ifdef HAVE_DATA_CONTROL
+    if (m_dataControl) {
+        m_dataControl->abortRead();
+    }
+#endif
+    finishRead(false);
+}
+
+void ClipboardManager::startFallback()
+{
+    m_wlPaste = QStandardPaths::findExecutable(QStringLiteral("wl-paste"));
+
+    // Qt only sees changes reliably on X11 or while focused, wl-paste --watch
+    // covers the rest on Wayland
+    connect(m_clipboard, &QClipboard::dataChanged, this, &ClipboardManager::refresh);
+    startWatcher();
+
+    refresh();
+}
+
+void ClipboardManager::startWatcher()
+{
+    if (m_wlPaste.isEmpty()) {
+        return;
+    }
+
+    // Prints a line on every selection change, including once at startup
+    m_watcher = new QProcess(this);
+    m_watcher->setStandardErrorFile(QProcess::nullDevice());
+    connect(m_watcher, &QProcess::readyReadStandardOutput, this, [this]() {
+        m_watcher->readAllStandardOutput();
+        refresh();
+    });
+    connect(m_watcher, &QProcess::finished, this, &ClipboardManager::onWatcherFinished);
+    m_watcher->start(m_wlPaste, {QStringLiteral("--watch"), QStringLiteral("echo")});
+}
+
+bool ClipboardManager::isWatching() const
+{
+    return m_watcher && m_watcher->state() != QProcess::NotRunning;
+}
+
+void ClipboardManager::onWatcherFinished()
+{
+    // Compositor without data-control support; read on demand instead
+    qWarning() << "wl-paste --watch exited, reading the clipboard on demand";
+    m_watcher->deleteLater();
+    m_watcher = nullptr;
+}
+
+void ClipboardManager::beginRead()
+{
+    m_reading = true;
+    m_retrying = std::exchange(m_retryPending, false);
+    m_normalizer.reset();
+    m_incoming.clear();
+    m_stallTimer->start();
+}
+
+void ClipboardManager::appendData(QByteArrayView data)
+{
+    if (!m_reading || data.isEmpty()) {
+        return;
+    }
+    m_stallTimer->start();
+
+    // Normalize line endings (\r\n and \r -> \n) as data arrives, so the
+    // transfer is never held twice
+    m_normalizer.feed(data, m_incoming);
+}
+
+void ClipboardManager::finishRead(bool complete)
+{
+    if (!m_reading) {
+        return;
+    }
+    m_reading = false;
+    m_stallTimer->stop();
+
+    m_normalizer.finish();
+    QByteArray text = std::move(m_incoming);
+    m_incoming = QByteArray();
+
+    m_stale = false;
+    if (!complete) {
+        // Part of a transfer is worse than the text from before
+        if (!m_dataControl && !m_clipboard->text().isEmpty()) {
+            setQtClipboardText();
+        } else {
+            m_stale = !m_retrying;
+        }
+    } else if (!text.isEmpty()) {
+        setText(text, m_normalizer.stats());
+    } else if (!m_dataControl) {
+        // Fallback to Qt clipboard
+        setQtClipboardText();
+    } else {
+        setText(text, TextNormalizer::Stats());
+    }
+
+    Q_EMIT readFinished(complete);
+}
+
+void ClipboardManager::setQtClipboardText()
+{
+    TextNormalizer::Stats stats;
+    const QByteArray text = TextNormalizer::normalized(m_clipboard->text().toUtf8(), &stats);
+    setText(text, stats);
+}
+
+void ClipboardManager::setText(const QByteArray& text, const TextNormalizer::Stats& stats)
+{
+    if (!stats.valid) {
+        // Rare; replace bad sequences with U+FFFD so the counts hold
+        qWarning() << "Clipboard text is not valid UTF-8";
+        TextNormalizer::Stats fixed;
+        const QByteArray repaired = TextNormalizer::normalized(QString::fromUtf8(text).toUtf8(), &fixed);
+        setText(repaired, fixed);
+        return;
+    }
+
+    m_stats = stats;
+    if (text != m_text) {
+        m_text = text;
+        if (!text.isEmpty()) {
+            m_history.add(text, stats);
+        }
+        Q_EMIT textChanged();
+    }
 }
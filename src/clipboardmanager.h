@@ -1,24 +1,96 @@
 #ifndef CLIPBOARDMANAGER_H
 #define CLIPBOARDMANAGER_H
 
+#include "clipboardhistory.h"
+#include "textnormalizer.h"
+
+#include <QByteArray>
+#include <QByteArrayView>
 #include <QObject>
+#include <QProcess>
 #include <QString>
 
 class QClipboard;
+class QTimer;
+class DataControlClipboard;
 
+// Keeps a normalized snapshot of the clipboard text that is refreshed in
+// the background whenever the clipboard changes, so reading it on the
+// hotkey path does not spawn anything.
+//
+// Transfers are streamed and normalized as they arrive. There is no overall
+// time limit, a read is only abandoned if the source stops sending data.
+// A failed read keeps the text from before and marks it stale; the next
+// ensureCurrent() tries once more before settling for it.
+// The text is kept as UTF-8 with \n line endings, the form the encoder
+// consumes.
 class ClipboardManager : public QObject
 {
     Q_OBJECT
 
 public:
     explicit ClipboardManager(QObject* parent = nullptr);
-    ~ClipboardManager() = default;
+    ~ClipboardManager();
 
-    QString getText() const;
+    QByteArray getText() const;
     bool hasText() const;
+    qsizetype characterCount() const;
+    qsizetype lineCount() const;
+
+    // Earlier clipboard texts; entry 0 is the current one
+    const ClipboardHistory& history() const;
+    void setHistoryMemoryLimit(qsizetype bytes);
+
+    // Returns true if getText() is up to date. Otherwise a read is in
+    // progress and readFinished() follows when it completes or fails.
+    bool ensureCurrent();
+    bool isReading() const;
+
+Q_SIGNALS:
+    void textChanged();
+    // ok is false if the transfer failed; getText() then holds Qt's view of
+    // the clipboard when reading through wl-paste and it has text, and the
+    // last text read otherwise
+    void readFinished(bool ok);
+
+private Q_SLOTS:
+    void refresh();
+    void onReaderFinished(int exitCode, QProcess::ExitStatus exitStatus);
+    void onReaderError(QProcess::ProcessError error);
+    void onWatcherFinished();
+    void onReadStalled();
 
 private:
+    void startFallback();
+    void startWatcher();
+    bool isWatching() const;
+
+    void beginRead();
+    void appendData(QByteArrayView data);
+    void finishRead(bool complete);
+    void setText(const QByteArray& text, const TextNormalizer::Stats& stats);
+    void setQtClipboardText();
+
     QClipboard* m_clipboard;
+    DataControlClipboard* m_dataControl;
+    QString m_wlPaste;
+    QProcess* m_watcher;
+    QProcess* m_reader;
+    bool m_refreshPending;
+
+    // Incoming transfer. A retry of a stale snapshot that fails as well
+    // leaves it as it is, rather than being tried on every call.
+    bool m_reading;
+    bool m_stale;
+    bool m_retryPending;
+    bool m_retrying;
+    TextNormalizer m_normalizer;
+    QByteArray m_incoming;
+    QTimer* m_stallTimer;
+
+    QByteArray m_text;
+    TextNormalizer::Stats m_stats;
+    ClipboardHistory m_history;
 };
 
 #endif // CLIPBOARDMANAGER_H
@@ -0,0 +1,188 @@
+#include "commandclient.h"
+#include "commandserver.h"
+
+#include <QByteArray>
+#include <QFile>
+
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+struct Request
+{
+    QByteArray command;
+    QByteArray payload;
+    // Read only after connecting, so a newly started instance can read it instead
+    bool payloadFromStdin = false;
+};
+
+// Accepts both "--option value" and "--option=value"
+bool optionValue(int argc, char* argv[], int& i, const char* name, QByteArray& value)
+{
+    const size_t length = std::strlen(name);
+    if (std::strncmp(argv[i], name, length) != 0) {
+        return false;
+    }
+    if (argv[i][length] == '=') {
+        value = argv[i] + length + 1;
+        return true;
+    }
+    if (argv[i][length] == '\0' && i + 1 < argc) {
+        value = argv[++i];
+        return true;
+    }
+    return false;
+}
+
+QByteArray readStandardInput()
+{
+    QByteArray text;
+    char buffer[65536];
+    size_t n;
+    while ((n = std::fread(buffer, 1, sizeof(buffer), stdin)) > 0) {
+        text.append(buffer, qsizetype(n));
+    }
+    return text;
+}
+
+bool parse(int argc, char* argv[], Request& request)
+{
+    for (int i = 1; i < argc; ++i) {
+        QByteArray value;
+        if (optionValue(argc, argv, i, "--type-text", value)) {
+            request.command = "type-text";
+            request.payload = value;
+            request.payloadFromStdin = value == "-";
+            return true;
+        }
+        if (optionValue(argc, argv, i, "--type-file", value)) {
+            // The running instance has its own working directory
+            char resolved[PATH_MAX];
+            request.command = "type-file";
+            request.payload = realpath(value.constData(), resolved) ? QByteArray(resolved) : value;
+            return true;
+        }
+        if (std::strcmp(argv[i], "--cancel") == 0) {
+            request.command = "cancel";
+            return true;
+        }
+        if (std::strcmp(argv[i], "--status") == 0) {
+            request.command = "status";
+            return true;
+        }
+    }
+    return false;
+}
+
+int connectToInstance()
+{
+    const QByteArray path = QFile::encodeName(CommandServer::socketPath());
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (size_t(path.size()) >= sizeof(address.sun_path)) {
+        return -1;
+    }
+    std::memcpy(address.sun_path, path.constData(), path.size());
+
+    const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    if (connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool writeAll(int fd, const QByteArray& data)
+{
+    qsizetype written = 0;
+    while (written < data.size()) {
+        const ssize_t n = send(fd, data.constData() + written, size_t(data.size() - written), MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        written += n;
+    }
+    return true;
+}
+
+QByteArray readReply(int fd)
+{
+    QByteArray reply;
+    char buffer[256];
+    for (;;) {
+        const ssize_t n = read(fd, buffer, sizeof(buffer));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        reply.append(buffer, n);
+    }
+    return reply.trimmed();
+}
+
+} // namespace
+
+namespace CommandClient {
+
+int forward(int argc, char* argv[])
+{
+    Request request;
+    if (!parse(argc, argv, request)) {
+        return -1;
+    }
+
+    const int fd = connectToInstance();
+    if (fd < 0) {
+        // Typing starts an instance that does it; the rest need one running
+        if (request.command.startsWith("type-")) {
+            return -1;
+        }
+        std::fprintf(stderr, "ClickPaste is not running\n");
+        return 1;
+    }
+
+    if (request.payloadFromStdin) {
+        request.payload = readStandardInput();
+    }
+    if (request.payload.size() > CommandServer::MaxPayload) {
+        std::fprintf(stderr, "Text too large, use --type-file\n");
+        close(fd);
+        return 1;
+    }
+
+    const QByteArray header = request.command + ' ' + QByteArray::number(request.payload.size()) + '\n';
+    const bool sent = writeAll(fd, header) && writeAll(fd, request.payload);
+    const QByteArray reply = sent ? readReply(fd) : QByteArray();
+    close(fd);
+
+    if (reply == "ok") {
+        return 0;
+    }
+    if (reply.startsWith("ok ")) {
+        std::printf("%s\n", reply.constData() + 3);
+        return 0;
+    }
+    if (reply.startsWith("error ")) {
+        std::fprintf(stderr, "ClickPaste: %s\n", reply.constData() + 6);
+    } else {
+        std::fprintf(stderr, "ClickPaste did not answer\n");
+    }
+    return 1;
+}
+
+}
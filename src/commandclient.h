@@ -0,0 +1,16 @@
+#ifndef COMMANDCLIENT_H
+#define COMMANDCLIENT_H
+
+// Hands --type-text, --type-file, --cancel and --status to a running
+// instance over its command socket. Runs before QApplication, so a
+// forwarded command costs no GUI, D-Bus or KDE start-up.
+namespace CommandClient {
+
+// Returns the exit code when the command line was handled here, or -1 to
+// start normally: no command was given, or typing was asked for and no
+// instance is running
+int forward(int argc, char* argv[]);
+
+}
+
+#endif // COMMANDCLIENT_H
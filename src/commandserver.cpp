@@ -0,0 +1,211 @@
+#include "commandserver.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QStandardPaths>
+#include <QTimer>
+
+namespace {
+// A client that has not sent its whole request by then is dropped
+constexpr int RequestTimeoutMs = 10000;
+// "type-text 67108864\n" and some room
+constexpr qint64 MaxRequestLine = 64;
+}
+
+CommandServer::CommandServer(QObject* parent)
+    : QObject(parent)
+    , m_server(new QLocalServer(this))
+    , m_state(Starting)
+    , m_current(0)
+    , m_total(0)
+{
+    // Typing into the user's windows is not for other users
+    m_server->setSocketOptions(QLocalServer::UserAccessOption);
+    connect(m_server, &QLocalServer::newConnection,
+            this, &CommandServer::onNewConnection);
+}
+
+CommandServer::~CommandServer()
+{
+    // Open connections go with the server, while m_requests still exists
+    delete m_server;
+}
+
+bool CommandServer::listen()
+{
+    const QString path = socketPath();
+    QLocalServer::removeServer(path);
+    return m_server->listen(path);
+}
+
+QString CommandServer::errorString() const
+{
+    return m_server->errorString();
+}
+
+void CommandServer::setState(State state)
+{
+    m_state = state;
+}
+
+CommandServer::State CommandServer::state() const
+{
+    return m_state;
+}
+
+void CommandServer::setProgress(int current, int total)
+{
+    m_current = current;
+    m_total = total;
+}
+
+void CommandServer::refuse(const QString& reason)
+{
+    m_refusal = reason;
+}
+
+QString CommandServer::socketPath()
+{
+    // Same directory as the instance lock
+    QString path = QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation);
+    if (path.isEmpty()) {
+        path = QStandardPaths::writableLocation(QStandardPaths::TempLocation);
+    }
+    return path + QStringLiteral("/clickpaste.sock");
+}
+
+void CommandServer::onNewConnection()
+{
+    while (QLocalSocket* socket = m_server->nextPendingConnection()) {
+        connect(socket, &QLocalSocket::readyRead, this, [this, socket]() {
+            onReadyRead(socket);
+        });
+        connect(socket, &QLocalSocket::disconnected, socket, &QObject::deleteLater);
+        connect(socket, &QObject::destroyed, this, [this, socket]() {
+            m_requests.remove(socket);
+        });
+        QTimer::singleShot(RequestTimeoutMs, socket, [socket]() {
+            socket->abort();
+        });
+    }
+}
+
+void CommandServer::onReadyRead(QLocalSocket* socket)
+{
+    // Anything after the request is ignored
+    auto reply = [this, socket](const QByteArray& line) {
+        m_requests[socket].handled = true;
+        socket->write(line + '\n');
+        socket->disconnectFromServer();
+    };
+
+    auto it = m_requests.constFind(socket);
+    if (it == m_requests.constEnd()) {
+        if (!socket->canReadLine()) {
+            if (socket->bytesAvailable() > MaxRequestLine) {
+                reply(QByteArrayLiteral("error malformed request"));
+            }
+            return;
+        }
+        const QByteArray line = socket->readLine(MaxRequestLine).trimmed();
+        const qsizetype space = line.indexOf(' ');
+        bool ok = false;
+        const qint64 length = space < 0 ? -1 : line.mid(space + 1).toLongLong(&ok);
+        if (!ok || length < 0) {
+            reply(QByteArrayLiteral("error malformed request"));
+            return;
+        }
+        if (length > MaxPayload) {
+            reply(QByteArrayLiteral("error text too large, use --type-file"));
+            return;
+        }
+        Request request;
+        request.command = line.left(space);
+        request.length = length;
+        it = m_requests.insert(socket, request);
+    }
+
+    // The payload stays in the socket buffer until it is complete
+    if (it->handled || socket->bytesAvailable() < it->length) {
+        return;
+    }
+    const QByteArray command = it->command;
+    const QByteArray payload = socket->read(it->length);
+    reply(handle(command, payload));
+}
+
+QByteArray CommandServer::handle(const QByteArray& command, const QByteArray& payload)
+{
+    if (command == "status") {
+        return QByteArrayLiteral("ok ") + status();
+    }
+    if (command == "cancel") {
+        Q_EMIT cancelRequested();
+        return QByteArrayLiteral("ok");
+    }
+
+    // Typing commands are refused rather than queued, like the hotkey
+    if (m_state == Typing || m_state == Paused) {
+        return QByteArrayLiteral("error busy, ") + status();
+    }
+    if (command == "type-text") {
+        if (payload.isEmpty()) {
+            return QByteArrayLiteral("error empty text");
+        }
+        if (!payload.isValidUtf8()) {
+            return QByteArrayLiteral("error invalid UTF-8");
+        }
+        m_refusal.clear();
+        Q_EMIT typeTextRequested(payload);
+        return started();
+    }
+    if (command == "type-file") {
+        const QString path = QFile::decodeName(payload);
+        if (!path.startsWith(QLatin1Char('/'))) {
+            return QByteArrayLiteral("error path must be absolute");
+        }
+        // Caught here so the client hears about it, not only the tray
+        const QFileInfo info(path);
+        if (!info.isFile() || !info.isReadable()) {
+            return QByteArrayLiteral("error cannot read ") + payload;
+        }
+        m_refusal.clear();
+        Q_EMIT typeFileRequested(path);
+        return started();
+    }
+
+    qWarning() << "Unknown command on the command socket:" << command;
+    return QByteArrayLiteral("error unknown command");
+}
+
+QByteArray CommandServer::started() const
+{
+    // The receiver has either queued the paste and set Typing by now,
+    // refused it, or dropped it because one was already on its way to the
+    // worker
+    if (!m_refusal.isEmpty()) {
+        return QByteArrayLiteral("error ") + m_refusal.section(QLatin1Char('\n'), 0, 0).toUtf8();
+    }
+    if (m_state != Typing) {
+        return QByteArrayLiteral("error busy, ") + status();
+    }
+    return QByteArrayLiteral("ok");
+}
+
+QByteArray CommandServer::status() const
+{
+    switch (m_state) {
+    case Starting:
+        return QByteArrayLiteral("starting");
+    case Idle:
+        return QByteArrayLiteral("idle");
+    case Typing:
+        return QByteArrayLiteral("typing ") + QByteArray::number(m_current) + '/' + QByteArray::number(m_total);
+    case Paused:
+        return QByteArrayLiteral("paused ") + QByteArray::number(m_current) + '/' + QByteArray::number(m_total);
+    }
+    return QByteArray();
+}
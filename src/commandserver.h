@@ -0,0 +1,85 @@
+#ifndef COMMANDSERVER_H
+#define COMMANDSERVER_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QObject>
+#include <QString>
+
+class QLocalServer;
+class QLocalSocket;
+
+// Takes commands from later `clickpaste --type-text/--type-file/--cancel/
+// --status` invocations on a local socket next to the instance lock.
+//
+// One request per connection: a line "<command> <payload length>\n" and
+// then the payload. Commands are type-text (UTF-8 payload, refused when
+// malformed), type-file (absolute path), cancel and status. The reply is
+// one line, "ok" with an optional detail, or "error <reason>".
+class CommandServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum State {
+        Starting,
+        Idle,
+        Typing,
+        Paused
+    };
+
+    // Larger texts should be sent as a file
+    static constexpr qint64 MaxPayload = 64 * 1024 * 1024;
+
+    explicit CommandServer(QObject* parent = nullptr);
+    ~CommandServer();
+
+    // Only call while holding the instance lock; a socket file left behind
+    // by a crashed instance is removed
+    bool listen();
+    QString errorString() const;
+
+    // What status replies with; progress counts characters. Typing must be
+    // set before a typing signal returns, anything else is taken as refused.
+    void setState(State state);
+    State state() const;
+    void setProgress(int current, int total);
+
+    // Turns down the typing request being handled; the client is told
+    // "error <reason>" (its first line) instead of "busy"
+    void refuse(const QString& reason);
+
+    // Usable before QCoreApplication exists
+    static QString socketPath();
+
+Q_SIGNALS:
+    void typeTextRequested(const QByteArray& text);
+    void typeFileRequested(const QString& path);
+    void cancelRequested();
+
+private Q_SLOTS:
+    void onNewConnection();
+
+private:
+    void onReadyRead(QLocalSocket* socket);
+    QByteArray handle(const QByteArray& command, const QByteArray& payload);
+    QByteArray started() const;
+    QByteArray status() const;
+
+    // A connection whose request line has been read
+    struct Request
+    {
+        QByteArray command;
+        qint64 length = 0;
+        bool handled = false;
+    };
+
+    QLocalServer* m_server;
+    QHash<QLocalSocket*, Request> m_requests;
+    State m_state;
+    QString m_refusal;
+    int m_current;
+    int m_total;
+};
+
+#endif // COMMANDSERVER_H
@@ -0,0 +1,334 @@
+#include "datacontrolclipboard.h"
+
+#include <QDebug>
+#include <QSocketNotifier>
+
+#include <wayland-client.h>
+#include "wayland-ext-data-control-v1-client-protocol.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+// In order of preference
+const char* const TextMimeTypes[] = {
+    "text/plain;charset=utf-8",
+    "UTF8_STRING",
+    "text/plain",
+    "TEXT",
+    "STRING",
+};
+
+} // namespace
+
+DataControlClipboard::DataControlClipboard(QObject* parent)
+    : QObject(parent)
+    , m_display(nullptr)
+    , m_registry(nullptr)
+    , m_seat(nullptr)
+    , m_manager(nullptr)
+    , m_device(nullptr)
+    , m_displayNotifier(nullptr)
+    , m_selection(nullptr)
+    , m_readFd(-1)
+    , m_readNotifier(nullptr)
+{
+}
+
+DataControlClipboard::~DataControlClipboard()
+{
+    teardown();
+}
+
+bool DataControlClipboard::start()
+{
+    if (m_display) {
+        return isActive();
+    }
+
+    m_display = wl_display_connect(nullptr);
+    if (!m_display) {
+        return false;
+    }
+
+    static const wl_registry_listener registryListener = {
+        handleGlobal,
+        handleGlobalRemove,
+    };
+    m_registry = wl_display_get_registry(m_display);
+    wl_registry_add_listener(m_registry, &registryListener, this);
+    wl_display_roundtrip(m_display);
+
+    if (!m_manager || !m_seat) {
+        qDebug() << "Compositor does not support ext-data-control-v1";
+        teardown();
+        return false;
+    }
+
+    static const ext_data_control_device_v1_listener deviceListener = {
+        handleDataOffer,
+        handleSelection,
+        handleFinished,
+        handlePrimarySelection,
+    };
+    m_device = ext_data_control_manager_v1_get_data_device(m_manager, m_seat);
+    ext_data_control_device_v1_add_listener(m_device, &deviceListener, this);
+
+    m_displayNotifier = new QSocketNotifier(wl_display_get_fd(m_display), QSocketNotifier::Read, this);
+    connect(m_displayNotifier, &QSocketNotifier::activated, this, &DataControlClipboard::dispatch);
+
+    // Delivers the current selection right away
+    wl_display_roundtrip(m_display);
+    return true;
+}
+
+bool DataControlClipboard::isActive() const
+{
+    return m_device != nullptr;
+}
+
+bool DataControlClipboard::isReading() const
+{
+    return m_readFd >= 0;
+}
+
+void DataControlClipboard::abortRead()
+{
+    stopRead();
+}
+
+void DataControlClipboard::handleGlobal(void* data, wl_registry* registry, uint32_t name,
+                                        const char* interface, uint32_t version)
+{
+    Q_UNUSED(version)
+    auto* self = static_cast<DataControlClipboard*>(data);
+
+    if (qstrcmp(interface, ext_data_control_manager_v1_interface.name) == 0 && !self->m_manager) {
+        self->m_manager = static_cast<ext_data_control_manager_v1*>(
+            wl_registry_bind(registry, name, &ext_data_control_manager_v1_interface, 1));
+    } else if (qstrcmp(interface, wl_seat_interface.name) == 0 && !self->m_seat) {
+        self->m_seat = static_cast<wl_seat*>(wl_registry_bind(registry, name, &wl_seat_interface, 1));
+    }
+}
+
+void DataControlClipboard::handleGlobalRemove(void* data, wl_registry* registry, uint32_t name)
+{
+    Q_UNUSED(data)
+    Q_UNUSED(registry)
+    Q_UNUSED(name)
+}
+
+void DataControlClipboard::handleDataOffer(void* data, ext_data_control_device_v1* device,
+                                           ext_data_control_offer_v1* offer)
+{
+    Q_UNUSED(device)
+    static const ext_data_control_offer_v1_listener offerListener = {
+        handleOffer,
+    };
+
+    auto* self = static_cast<DataControlClipboard*>(data);
+    self->m_offers.insert(offer, QByteArrayList());
+    ext_data_control_offer_v1_add_listener(offer, &offerListener, self);
+}
+
+void DataControlClipboard::handleOffer(void* data, ext_data_control_offer_v1* offer, const char* mimeType)
+{
+    auto* self = static_cast<DataControlClipboard*>(data);
+    auto it = self->m_offers.find(offer);
+    if (it != self->m_offers.end()) {
+        it->append(QByteArray(mimeType));
+    }
+}
+
+void DataControlClipboard::handleSelection(void* data, ext_data_control_device_v1* device,
+                                           ext_data_control_offer_v1* offer)
+{
+    Q_UNUSED(device)
+    static_cast<DataControlClipboard*>(data)->setSelection(offer);
+}
+
+void DataControlClipboard::handleFinished(void* data, ext_data_control_device_v1* device)
+{
+    Q_UNUSED(device)
+    qWarning() << "ext-data-control device finished";
+
+    // Can't disconnect from inside a dispatch
+    auto* self = static_cast<DataControlClipboard*>(data);
+    QMetaObject::invokeMethod(self, &DataControlClipboard::lose, Qt::QueuedConnection);
+}
+
+void DataControlClipboard::handlePrimarySelection(void* data, ext_data_control_device_v1* device,
+                                                  ext_data_control_offer_v1* offer)
+{
+    Q_UNUSED(device)
+    // We only type the regular clipboard
+    if (offer) {
+        static_cast<DataControlClipboard*>(data)->destroyOffer(offer);
+    }
+}
+
+void DataControlClipboard::dispatch()
+{
+    if (wl_display_dispatch(m_display) < 0) {
+        qWarning() << "Lost the Wayland connection used for the clipboard";
+        lose();
+        return;
+    }
+    wl_display_flush(m_display);
+}
+
+void DataControlClipboard::setSelection(ext_data_control_offer_v1* offer)
+{
+    stopRead();
+    if (m_selection && m_selection != offer) {
+        destroyOffer(m_selection);
+    }
+    m_selection = offer;
+
+    Q_EMIT selectionChanged();
+    readSelection();
+}
+
+void DataControlClipboard::readSelection()
+{
+    stopRead();
+
+    if (m_selection) {
+        const QByteArrayList mimeTypes = m_offers.value(m_selection);
+        for (const char* mimeType : TextMimeTypes) {
+            if (mimeTypes.contains(QByteArray(mimeType))) {
+                startRead(m_selection, QByteArray(mimeType));
+                return;
+            }
+        }
+    }
+
+    // Cleared, or nothing we can type (e.g. an image)
+    Q_EMIT textFinished(true);
+}
+
+void DataControlClipboard::destroyOffer(ext_data_control_offer_v1* offer)
+{
+    m_offers.remove(offer);
+    ext_data_control_offer_v1_destroy(offer);
+    if (m_selection == offer) {
+        m_selection = nullptr;
+    }
+}
+
+void DataControlClipboard::startRead(ext_data_control_offer_v1* offer, const QByteArray& mimeType)
+{
+    int fds[2];
+    if (::pipe2(fds, O_CLOEXEC | O_NONBLOCK) != 0) {
+        qWarning() << "Could not create clipboard pipe:" << strerror(errno);
+        Q_EMIT textFinished(false);
+        return;
+    }
+
+    // The write end is duplicated into the request, so we can close ours now
+    ext_data_control_offer_v1_receive(offer, mimeType.constData(), fds[1]);
+    wl_display_flush(m_display);
+    ::close(fds[1]);
+
+    m_readFd = fds[0];
+    m_readNotifier = new QSocketNotifier(m_readFd, QSocketNotifier::Read, this);
+    connect(m_readNotifier, &QSocketNotifier::activated, this, &DataControlClipboard::readAvailable);
+}
+
+void DataControlClipboard::readAvailable()
+{
+    // Hand data on as it arrives instead of collecting the whole transfer
+    char chunk[65536];
+    bool ok = true;
+    for (;;) {
+        const ssize_t n = ::read(m_readFd, chunk, sizeof(chunk));
+        if (n > 0) {
+            Q_EMIT textData(QByteArrayView(chunk, n));
+            if (m_readFd < 0) {
+                return; // aborted from a slot
+            }
+            continue;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && errno == EAGAIN) {
+            return;
+        }
+        if (n < 0) {
+            qWarning() << "Could not read the clipboard:" << strerror(errno);
+            ok = false;
+        }
+        break; // EOF or error
+    }
+
+    stopRead();
+    Q_EMIT textFinished(ok);
+}
+
+void DataControlClipboard::stopRead()
+{
+    if (m_readNotifier) {
+        // May be called from the notifier's own signal
+        m_readNotifier->setEnabled(false);
+        m_readNotifier->deleteLater();
+        m_readNotifier = nullptr;
+    }
+    if (m_readFd >= 0) {
+        ::close(m_readFd);
+        m_readFd = -1;
+    }
+}
+
+void DataControlClipboard::teardown()
+{
+    stopRead();
+    if (m_displayNotifier) {
+        m_displayNotifier->setEnabled(false);
+        m_displayNotifier->deleteLater();
+        m_displayNotifier = nullptr;
+    }
+
+    if (!m_display) {
+        return;
+    }
+
+    for (auto it = m_offers.cbegin(); it != m_offers.cend(); ++it) {
+        ext_data_control_offer_v1_destroy(it.key());
+    }
+    m_offers.clear();
+    m_selection = nullptr;
+
+    if (m_device) {
+        ext_data_control_device_v1_destroy(m_device);
+        m_device = nullptr;
+    }
+    if (m_manager) {
+        ext_data_control_manager_v1_destroy(m_manager);
+        m_manager = nullptr;
+    }
+    if (m_seat) {
+        wl_seat_destroy(m_seat);
+        m_seat = nullptr;
+    }
+    if (m_registry) {
+        wl_registry_destroy(m_registry);
+        m_registry = nullptr;
+    }
+
+    wl_display_flush(m_display);
+    wl_display_disconnect(m_display);
+    m_display = nullptr;
+}
+
+void DataControlClipboard::lose()
+{
+    if (!m_display) {
+        return;
+    }
+    teardown();
+    Q_EMIT lost();
+}
@@ -0,0 +1,86 @@
+#ifndef DATACONTROLCLIPBOARD_H
+#define DATACONTROLCLIPBOARD_H
+
+#include <QByteArray>
+#include <QByteArrayList>
+#include <QByteArrayView>
+#include <QHash>
+#include <QObject>
+
+struct wl_display;
+struct wl_registry;
+struct wl_seat;
+struct ext_data_control_manager_v1;
+struct ext_data_control_device_v1;
+struct ext_data_control_offer_v1;
+
+class QSocketNotifier;
+
+// Reads the clipboard selection through the ext-data-control-v1 protocol on
+// a private Wayland connection. Works without focus and without wl-paste.
+class DataControlClipboard : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit DataControlClipboard(QObject* parent = nullptr);
+    ~DataControlClipboard();
+
+    // Returns false if not on Wayland or the compositor lacks ext-data-control.
+    // The current selection is reported right away.
+    bool start();
+    bool isActive() const;
+
+    bool isReading() const;
+    void abortRead();
+
+    // Reads the current selection again, for a transfer that failed
+    void readSelection();
+
+Q_SIGNALS:
+    // Followed by any number of textData() and then textFinished(). ok is
+    // false if the transfer broke off; an empty or non-text selection is ok.
+    void selectionChanged();
+    void textData(QByteArrayView data);
+    void textFinished(bool ok);
+    // The compositor ended the device or the connection broke; the object
+    // stays inactive from then on
+    void lost();
+
+private:
+    static void handleGlobal(void* data, wl_registry* registry, uint32_t name,
+                             const char* interface, uint32_t version);
+    static void handleGlobalRemove(void* data, wl_registry* registry, uint32_t name);
+    static void handleDataOffer(void* data, ext_data_control_device_v1* device,
+                                ext_data_control_offer_v1* offer);
+    static void handleSelection(void* data, ext_data_control_device_v1* device,
+                                ext_data_control_offer_v1* offer);
+    static void handleFinished(void* data, ext_data_control_device_v1* device);
+    static void handlePrimarySelection(void* data, ext_data_control_device_v1* device,
+                                       ext_data_control_offer_v1* offer);
+    static void handleOffer(void* data, ext_data_control_offer_v1* offer, const char* mimeType);
+
+    void dispatch();
+    void setSelection(ext_data_control_offer_v1* offer);
+    void destroyOffer(ext_data_control_offer_v1* offer);
+    void startRead(ext_data_control_offer_v1* offer, const QByteArray& mimeType);
+    void readAvailable();
+    void stopRead();
+    void teardown();
+    void lose();
+
+    wl_display* m_display;
+    wl_registry* m_registry;
+    wl_seat* m_seat;
+    ext_data_control_manager_v1* m_manager;
+    ext_data_control_device_v1* m_device;
+    QSocketNotifier* m_displayNotifier;
+
+    QHash<ext_data_control_offer_v1*, QByteArrayList> m_offers;
+    ext_data_control_offer_v1* m_selection;
+
+    int m_readFd;
+    QSocketNotifier* m_readNotifier;
+};
+
+#endif // DATACONTROLCLIPBOARD_H
@@ -0,0 +1,281 @@
+#include "eventencoder.h"
+
+#include <cstring>
+
+void EventBuffer::reserve(int capacity)
+{
+    if (capacity <= m_capacity) {
+        return;
+    }
+
+    const int newCapacity = qMax(capacity, m_capacity * 2);
+    std::unique_ptr<input_event[]> data(new input_event[newCapacity]);
+    if (m_size > 0) {
+        std::memcpy(data.get(), m_data.get(), sizeof(input_event) * m_size);
+    }
+    m_data = std::move(data);
+    m_capacity = newCapacity;
+}
+
+void KeyState::apply(const input_event* events, int count)
+{
+    for (int i = 0; i < count; ++i) {
+        const input_event& event = events[i];
+        // value 2 is autorepeat, which does not change the state
+        if (event.type == EV_KEY && event.code < KEY_CNT && event.value != 2) {
+            m_down.set(event.code, event.value != 0);
+        }
+    }
+}
+
+void KeyState::assumePressed(const input_event* events, int count)
+{
+    for (int i = 0; i < count; ++i) {
+        const input_event& event = events[i];
+        if (event.type == EV_KEY && event.code < KEY_CNT && event.value == 1) {
+            m_down.set(event.code);
+        }
+    }
+}
+
+input_event* KeyState::writeRelease(input_event* out) const
+{
+    for (size_t code = 0; code < m_down.size(); ++code) {
+        if (m_down.test(code)) {
+            out = EventEncoder::writeEvent(out, EV_KEY, static_cast<quint16>(code), 0);
+        }
+    }
+    return EventEncoder::writeEvent(out, EV_SYN, SYN_REPORT, 0);
+}
+
+int EventEncoder::encode(QByteArrayView text, EventBuffer& buffer)
+{
+    // Worst case up front, so the loop below never reallocates
+    const int perByte = m_hexEntry || m_composeKey ? MaxEventsPerByte : MaxEventsPerKey;
+    const int reserved = static_cast<int>(text.size()) * perByte;
+    input_event* const start = buffer.prepare(reserved);
+    input_event* out = start;
+    int skipped = 0;
+
+    for (qsizetype i = 0; i < text.size();) {
+        const int count = encodeCharacter(nextCodePoint(text, i), out);
+        if (count == 0) {
+            ++skipped;
+        }
+        out += count;
+    }
+
+    Q_ASSERT(out - start <= reserved);
+    buffer.commit(static_cast<int>(out - start));
+    return skipped;
+}
+
+int EventEncoder::encodeCharacter(char32_t ch, input_event* out)
+{
+    const KeyStroke stroke = Keymap::lookup(ch);
+    if (stroke.isValid()) {
+        return static_cast<int>((m_coalesce ? writeCoalesced(out, stroke) : writeStroke(out, stroke)) - out);
+    }
+
+    const Path route = path(ch);
+    if (route == Unmapped) {
+        return 0;
+    }
+
+    // Fallback sequences press their own modifiers; end the run first
+    input_event* p = out;
+    if (m_shiftDown) {
+        p = writeKey(p, KEY_LEFTSHIFT, 0);
+        m_shiftDown = false;
+    }
+    p = route == Compose ? writeCompose(p, Keymap::composeSequence(ch)) : writeHexEntry(p, ch);
+    return static_cast<int>(p - out);
+}
+
+EventEncoder::Path EventEncoder::path(char32_t ch) const
+{
+    if (Keymap::lookup(ch).isValid()) {
+        return Direct;
+    }
+
+    // Control characters cannot be entered either way, nor can Invalid
+    if (ch < 0xA0 || ch > 0x10FFFF || (ch >= 0xD800 && ch <= 0xDFFF)) {
+        return Unmapped;
+    }
+
+    const char* keys = m_composeKey ? Keymap::composeSequence(ch) : nullptr;
+    if (keys && (!m_hexEntry || composeEvents(keys) <= hexEntryEvents(ch))) {
+        return Compose;
+    }
+    return m_hexEntry ? HexEntry : Unmapped;
+}
+
+EventEncoder::Plan EventEncoder::plan(QByteArrayView text) const
+{
+    Plan plan;
+    for (qsizetype i = 0; i < text.size();) {
+        if (static_cast<uchar>(text[i]) < 0x80) {
+            // Plain ASCII is the bulk of any text
+            if (Keymap::lookup(static_cast<uchar>(text[i++])).isValid()) {
+                ++plan.direct;
+            } else {
+                ++plan.unmapped;
+            }
+            continue;
+        }
+
+        switch (path(nextCodePoint(text, i))) {
+        case Direct:
+            ++plan.direct;
+            break;
+        case Compose:
+            ++plan.compose;
+            break;
+        case HexEntry:
+            ++plan.hexEntry;
+            break;
+        case Unmapped:
+            ++plan.unmapped;
+            break;
+        }
+    }
+    return plan;
+}
+
+int EventEncoder::composeEvents(const char* keys) const
+{
+    int events = 4; // Compose press and release
+    for (const char* p = keys; *p; ++p) {
+        events += Keymap::lookup(static_cast<uchar>(*p)).modifiers & Keymap::Shift ? 8 : 4;
+    }
+    return events;
+}
+
+int EventEncoder::hexEntryEvents(char32_t ch)
+{
+    int digits = 1;
+    while (ch >>= 4) {
+        ++digits;
+    }
+    // Ctrl+Shift+U, the digits, Space
+    return 12 + digits * 4 + 4;
+}
+
+input_event* EventEncoder::writeStroke(input_event* out, KeyStroke stroke)
+{
+    const bool shift = stroke.modifiers & Keymap::Shift;
+    if (shift) {
+        out = writeKey(out, KEY_LEFTSHIFT, 1);
+    }
+    out = writeKey(out, stroke.code, 1);
+    out = writeKey(out, stroke.code, 0);
+    if (shift) {
+        out = writeKey(out, KEY_LEFTSHIFT, 0);
+    }
+    return out;
+}
+
+input_event* EventEncoder::writeCoalesced(input_event* out, KeyStroke stroke)
+{
+    // Shift changes only at the edges of a run
+    const bool shift = stroke.modifiers & Keymap::Shift;
+    if (shift != m_shiftDown) {
+        out = writeKey(out, KEY_LEFTSHIFT, shift ? 1 : 0);
+        m_shiftDown = shift;
+    }
+    out = writeKey(out, stroke.code, 1);
+    return writeKey(out, stroke.code, 0);
+}
+
+input_event* EventEncoder::writeCompose(input_event* out, const char* keys) const
+{
+    out = writeKey(out, m_composeKey, 1);
+    out = writeKey(out, m_composeKey, 0);
+    for (const char* p = keys; *p; ++p) {
+        out = writeStroke(out, Keymap::lookup(static_cast<uchar>(*p)));
+    }
+    return out;
+}
+
+input_event* EventEncoder::writeHexEntry(input_event* out, char32_t ch)
+{
+    static const char digits[] = "0123456789abcdef";
+
+    out = writeKey(out, KEY_LEFTCTRL, 1);
+    out = writeKey(out, KEY_LEFTSHIFT, 1);
+    out = writeKey(out, KEY_U, 1);
+    out = writeKey(out, KEY_U, 0);
+    out = writeKey(out, KEY_LEFTSHIFT, 0);
+    out = writeKey(out, KEY_LEFTCTRL, 0);
+
+    int shift = 0;
+    while (shift < 20 && (ch >> (shift + 4))) {
+        shift += 4;
+    }
+    for (; shift >= 0; shift -= 4) {
+        out = writeStroke(out, Keymap::lookup(static_cast<uchar>(digits[(ch >> shift) & 0xF])));
+    }
+
+    // Space ends the entry and commits the character
+    return writeStroke(out, Keymap::lookup(U' '));
+}
+
+char32_t EventEncoder::nextCodePoint(QByteArrayView text, qsizetype& index)
+{
+    const uchar lead = static_cast<uchar>(text[index++]);
+    if (lead < 0x80) {
+        return lead;
+    }
+
+    int need;
+    char32_t ch;
+    char32_t min;
+    if (lead >= 0xC2 && lead <= 0xDF) {
+        need = 1;
+        ch = lead & 0x1F;
+        min = 0x80;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+        need = 2;
+        ch = lead & 0x0F;
+        min = 0x800;
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+        need = 3;
+        ch = lead & 0x07;
+        min = 0x10000;
+    } else {
+        return Invalid;
+    }
+
+    if (text.size() - index < need) {
+        return Invalid;
+    }
+    for (int i = 0; i < need; ++i) {
+        const uchar byte = static_cast<uchar>(text[index + i]);
+        if ((byte & 0xC0) != 0x80) {
+            return Invalid;
+        }
+        ch = (ch << 6) | (byte & 0x3F);
+    }
+    if (ch < min || ch > 0x10FFFF || (ch >= 0xD800 && ch <= 0xDFFF)) {
+        return Invalid;
+    }
+
+    index += need;
+    return ch;
+}
+
+input_event* EventEncoder::writeEvent(input_event* out, quint16 type, quint16 code, qint32 value)
+{
+    out->input_event_sec = 0;
+    out->input_event_usec = 0;
+    out->type = type;
+    out->code = code;
+    out->value = value;
+    return out + 1;
+}
+
+input_event* EventEncoder::writeKey(input_event* out, quint16 code, qint32 value)
+{
+    out = writeEvent(out, EV_KEY, code, value);
+    return writeEvent(out, EV_SYN, SYN_REPORT, 0);
+}
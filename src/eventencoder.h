@@ -0,0 +1,152 @@
+#ifndef EVENTENCODER_H
+#define EVENTENCODER_H
+
+#include "keymap.h"
+
+#include <QByteArrayView>
+#include <bitset>
+#include <memory>
+
+#include <linux/input.h>
+
+// Contiguous, reusable storage for encoded input events
+class EventBuffer
+{
+public:
+    EventBuffer() = default;
+
+    const input_event* data() const { return m_data.get(); }
+    int size() const { return m_size; }
+    bool isEmpty() const { return m_size == 0; }
+    int capacity() const { return m_capacity; }
+
+    void clear() { m_size = 0; }
+    void reserve(int capacity);
+
+    // Returns room for count more events; commit() however many were written
+    input_event* prepare(int count)
+    {
+        reserve(m_size + count);
+        return m_data.get() + m_size;
+    }
+    void commit(int count) { m_size += count; }
+
+private:
+    std::unique_ptr<input_event[]> m_data;
+    int m_size = 0;
+    int m_capacity = 0;
+};
+
+// Keys held down on the virtual keyboard, as far as the events written to
+// it tell. Lets a cancelled paste release exactly what it pressed.
+class KeyState
+{
+public:
+    // Follows the presses and releases in events that were written
+    void apply(const input_event* events, int count);
+    // Marks every key pressed in events as down; for a write that failed
+    // and may have been cut short anywhere
+    void assumePressed(const input_event* events, int count);
+    void clear() { m_down.reset(); }
+
+    bool isEmpty() const { return m_down.none(); }
+    int count() const { return static_cast<int>(m_down.count()); }
+
+    // Writes a release for every held key and one SYN_REPORT, so out needs
+    // room for count() + 1 events. Returns the end.
+    input_event* writeRelease(input_event* out) const;
+
+private:
+    std::bitset<KEY_CNT> m_down;
+};
+
+// Turns UTF-8 text into evdev key events using the Keymap tables. Shared by
+// all in-process backends.
+//
+// Characters that have no key on the layout can go through a fallback: a
+// Compose key sequence, or the Ctrl+Shift+U hex entry that IBus and Fcitx
+// offer. When both are enabled the shorter one is used.
+//
+// With modifier coalescing, Shift stays down across a run of characters
+// that need it, so the encoder carries state from one character to the
+// next. Whoever stops writing must release the keys that are still down
+// and call resetModifiers().
+class EventEncoder
+{
+public:
+    // Shift down, key down, key up, Shift up, each followed by a SYN
+    static constexpr int MaxEventsPerKey = 8;
+    // Releasing a held Shift, Ctrl+Shift+U, six hex digits and Space
+    static constexpr int MaxEventsPerChar = 42;
+    // Fallbacks only apply to valid characters from U+00A0 up, which take
+    // at least two bytes; worst is a two byte one with three hex digits or
+    // a three key Compose sequence. Malformed bytes are never typed.
+    static constexpr int MaxEventsPerByte = 15;
+
+    // What nextCodePoint() returns for a malformed byte
+    static constexpr char32_t Invalid = 0xFFFFFFFF;
+
+    enum Path {
+        Direct,
+        Compose,
+        HexEntry,
+        Unmapped
+    };
+
+    // How the characters of a text will be typed
+    struct Plan
+    {
+        qsizetype direct = 0;
+        qsizetype compose = 0;
+        qsizetype hexEntry = 0;
+        qsizetype unmapped = 0;
+
+        qsizetype slowPath() const { return compose + hexEntry; }
+    };
+
+    void setHexEntry(bool enabled) { m_hexEntry = enabled; }
+    // Evdev code of the key the layout uses as Compose, 0 for none
+    void setComposeKey(quint16 code) { m_composeKey = code; }
+
+    // Holds Shift across runs of characters instead of pressing it for each
+    void setCoalesceModifiers(bool enabled) { m_coalesce = enabled; }
+    // Forgets a held Shift, after it was released from the outside
+    void resetModifiers() { m_shiftDown = false; }
+
+    Path path(char32_t ch) const;
+    Plan plan(QByteArrayView text) const;
+
+    // Encodes text in one pass into buffer. Returns the number of characters
+    // that cannot be typed and were skipped.
+    int encode(QByteArrayView text, EventBuffer& buffer);
+
+    // Writes the events for one character, returns how many (0 if it
+    // cannot be typed). out needs room for MaxEventsPerChar events.
+    int encodeCharacter(char32_t ch, input_event* out);
+
+    // Decodes the UTF-8 sequence at index and advances index past it.
+    // Malformed input yields Invalid, one byte at a time; unlike a real
+    // U+FFFD in the text it is skipped rather than typed.
+    static char32_t nextCodePoint(QByteArrayView text, qsizetype& index);
+
+    static input_event* writeEvent(input_event* out, quint16 type, quint16 code, qint32 value);
+
+    // Writes a key event followed by SYN_REPORT
+    static input_event* writeKey(input_event* out, quint16 code, qint32 value);
+
+private:
+    int composeEvents(const char* keys) const;
+    static int hexEntryEvents(char32_t ch);
+
+    static input_event* writeStroke(input_event* out, KeyStroke stroke);
+    input_event* writeCoalesced(input_event* out, KeyStroke stroke);
+    input_event* writeCompose(input_event* out, const char* keys) const;
+    static input_event* writeHexEntry(input_event* out, char32_t ch);
+
+    bool m_hexEntry = false;
+    quint16 m_composeKey = 0;
+    bool m_coalesce = false;
+    bool m_shiftDown = false;
+};
+
+#endif // EVENTENCODER_H
@@ -0,0 +1,85 @@
+#include "filereader.h"
+
+#include <QFile>
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+QString lastError()
+{
+    return QString::fromLocal8Bit(strerror(errno));
+}
+}
+
+FileReader::FileReader()
+    : m_fd(-1)
+    , m_size(0)
+{
+}
+
+FileReader::~FileReader()
+{
+    close();
+}
+
+bool FileReader::open(const QString& path)
+{
+    close();
+
+    m_fd = ::open(QFile::encodeName(path).constData(), O_RDONLY | O_CLOEXEC);
+    if (m_fd < 0) {
+        m_errorString = QStringLiteral("Could not open %1: %2").arg(path, lastError());
+        return false;
+    }
+
+    struct stat info;
+    if (::fstat(m_fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+        m_errorString = QStringLiteral("%1 is not a regular file").arg(path);
+        close();
+        return false;
+    }
+
+    ::posix_fadvise(m_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    m_size = info.st_size;
+    m_path = path;
+    return true;
+}
+
+void FileReader::close()
+{
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+    m_size = 0;
+    m_buffer = QByteArray();
+}
+
+QByteArrayView FileReader::read(qsizetype offset, qsizetype length)
+{
+    if (m_buffer.size() < length) {
+        m_buffer.resize(length);
+    }
+
+    qsizetype done = 0;
+    while (done < length) {
+        const ssize_t n = ::pread(m_fd, m_buffer.data() + done, length - done, offset + done);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            m_errorString = QStringLiteral("Could not read %1: %2").arg(m_path, lastError());
+            return QByteArrayView();
+        }
+        if (n == 0) {
+            m_errorString = QStringLiteral("%1 was truncated while it was being typed").arg(m_path);
+            return QByteArrayView();
+        }
+        done += n;
+    }
+    return QByteArrayView(m_buffer.constData(), length);
+}
@@ -0,0 +1,41 @@
+#ifndef FILEREADER_H
+#define FILEREADER_H
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QString>
+
+// Reads a file front to back in windows, with pread() into one reused
+// buffer, so memory stays bounded however large the file is. The file is
+// not mapped: one that shrinks while it is read (a rotated log, an editor
+// saving in place) ends in a read error instead of SIGBUS.
+class FileReader
+{
+public:
+    FileReader();
+    ~FileReader();
+
+    FileReader(const FileReader&) = delete;
+    FileReader& operator=(const FileReader&) = delete;
+
+    bool open(const QString& path);
+    void close();
+
+    // The size when the file was opened
+    qsizetype size() const { return m_size; }
+
+    // Reads length bytes at offset; the view is valid until the next read.
+    // Returns a null view if the bytes are no longer there, see errorString().
+    QByteArrayView read(qsizetype offset, qsizetype length);
+
+    QString errorString() const { return m_errorString; }
+
+private:
+    int m_fd;
+    qsizetype m_size;
+    QString m_path;
+    QByteArray m_buffer;
+    QString m_errorString;
+};
+
+#endif // FILEREADER_H
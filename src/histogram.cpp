@@ -0,0 +1,118 @@
+#include "histogram.h"
+
+void Histogram::record(qint64 value)
+{
+    const quint64 v = value > 0 ? quint64(value) : 0;
+    ++m_buckets[bucketFor(v)];
+    ++m_count;
+    m_max = qMax(m_max, qint64(v));
+}
+
+void Histogram::merge(const Histogram& other)
+{
+    for (int i = 0; i < BucketCount; ++i) {
+        m_buckets[i] += other.m_buckets[i];
+    }
+    m_count += other.m_count;
+    m_max = qMax(m_max, other.m_max);
+}
+
+void Histogram::clear()
+{
+    m_buckets.fill(0);
+    m_count = 0;
+    m_max = 0;
+}
+
+qint64 Histogram::percentile(double q) const
+{
+    if (m_count == 0) {
+        return 0;
+    }
+
+    const quint64 rank = qMin<quint64>(m_count - 1, quint64(qBound(0.0, q, 1.0) * m_count));
+    quint64 seen = 0;
+    for (int i = 0; i < BucketCount; ++i) {
+        seen += m_buckets[i];
+        if (seen > rank) {
+            const quint64 low = bucketLowerBound(i);
+            const quint64 high = i + 1 < BucketCount ? bucketLowerBound(i + 1) : low;
+            return qMin<qint64>(qint64(low + (high - low) / 2), m_max);
+        }
+    }
+    return m_max;
+}
+
+int Histogram::bucketFor(quint64 value)
+{
+    if (value < SubBuckets) {
+        return int(value);
+    }
+    // The two bits below the leading one pick the sub-bucket
+    const int exponent = 63 - __builtin_clzll(value);
+    const int sub = int((value >> (exponent - 2)) & (SubBuckets - 1));
+    return qMin((exponent - 1) * SubBuckets + sub, BucketCount - 1);
+}
+
+quint64 Histogram::bucketLowerBound(int bucket)
+{
+    if (bucket < SubBuckets) {
+        return quint64(bucket);
+    }
+    const int exponent = bucket / SubBuckets + 1;
+    const quint64 sub = quint64(bucket % SubBuckets);
+    return (SubBuckets + sub) << (exponent - 2);
+}
+
+RollingHistogram::RollingHistogram(quint64 window)
+    : m_window(window)
+{
+}
+
+void RollingHistogram::record(qint64 value)
+{
+    m_current.record(value);
+    rotateIfFull();
+}
+
+void RollingHistogram::merge(const Histogram& samples)
+{
+    m_current.merge(samples);
+    rotateIfFull();
+}
+
+void RollingHistogram::clear()
+{
+    m_current.clear();
+    m_previous.clear();
+}
+
+quint64 RollingHistogram::count() const
+{
+    return m_current.count() + m_previous.count();
+}
+
+qint64 RollingHistogram::max() const
+{
+    return qMax(m_current.max(), m_previous.max());
+}
+
+qint64 RollingHistogram::percentile(double q) const
+{
+    return combined().percentile(q);
+}
+
+void RollingHistogram::rotateIfFull()
+{
+    if (m_current.count() >= m_window) {
+        m_previous = m_current;
+        m_current.clear();
+    }
+}
+
+Histogram RollingHistogram::combined() const
+{
+    Histogram all = m_previous;
+    all.merge(m_current);
+    return all;
+}
@@ -0,0 +1,60 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <QtGlobal>
+#include <array>
+
+// Log-linear histogram of non-negative integers: four buckets per power of
+// two, so any percentile is within 12.5% of the true value. Fixed size,
+// cheap to copy and merge.
+class Histogram
+{
+public:
+    static constexpr int SubBuckets = 4;
+    static constexpr int BucketCount = 63 * SubBuckets;
+
+    void record(qint64 value);
+    void merge(const Histogram& other);
+    void clear();
+
+    quint64 count() const { return m_count; }
+    bool isEmpty() const { return m_count == 0; }
+    qint64 max() const { return m_max; }
+
+    // q in [0, 1]; returns the middle of the bucket holding that rank
+    qint64 percentile(double q) const;
+
+private:
+    static int bucketFor(quint64 value);
+    static quint64 bucketLowerBound(int bucket);
+
+    std::array<quint32, BucketCount> m_buckets = {};
+    quint64 m_count = 0;
+    qint64 m_max = 0;
+};
+
+// Keeps roughly the last window samples by rotating between two
+// generations; percentiles cover both.
+class RollingHistogram
+{
+public:
+    explicit RollingHistogram(quint64 window);
+
+    void record(qint64 value);
+    void merge(const Histogram& samples);
+    void clear();
+
+    quint64 count() const;
+    qint64 max() const;
+    qint64 percentile(double q) const;
+
+private:
+    void rotateIfFull();
+    Histogram combined() const;
+
+    quint64 m_window;
+    Histogram m_current;
+    Histogram m_previous;
+};
+
+#endif // HISTOGRAM_H
@@ -14,6 +14,7 @@ HotkeyManager::HotkeyManager(QObject* parent)
 
 HotkeyManager::~HotkeyManager()
 {
+    unregisterSlotHotkeys();
     unregisterHotkey();
 }
 
@@ -66,6 +67,50 @@ bool HotkeyManager::isRegistered() const
     return m_registered;
 }
 
+bool HotkeyManager::registerSlotHotkeys(int count, Qt::KeyboardModifiers modifiers)
+{
+    unregisterSlotHotkeys();
+
+    bool success = true;
+    for (int slot = 1; slot <= count && slot <= 9; ++slot) {
+        QAction* action = new QAction(this);
+        action->setObjectName(QStringLiteral("clickpaste_slot_%1").arg(slot));
+        action->setText(QStringLiteral("ClickPaste Type History Entry %1").arg(slot));
+
+        connect(action, &QAction::triggered, this, [this, slot]() {
+            if (m_enabled) {
+                Q_EMIT slotTriggered(slot);
+            }
+        });
+
+        const QKeySequence shortcut(modifiers | Qt::Key(Qt::Key_0 + slot));
+        if (!KGlobalAccel::setGlobalShortcut(action, {shortcut})) {
+            success = false;
+        }
+        m_slotActions.append(action);
+    }
+
+    if (!success) {
+        Q_EMIT registrationFailed(QStringLiteral("Some clipboard history hotkeys could not be registered. "
+                                                 "They may be in use by another application."));
+    }
+    return success;
+}
+
+void HotkeyManager::unregisterSlotHotkeys()
+{
+    for (QAction* action : std::as_const(m_slotActions)) {
+        KGlobalAccel::self()->removeAllShortcuts(action);
+        delete action;
+    }
+    m_slotActions.clear();
+}
+
+bool HotkeyManager::hasSlotHotkeys() const
+{
+    return !m_slotActions.isEmpty();
+}
+
 void HotkeyManager::setEnabled(bool enabled)
 {
     m_enabled = enabled;
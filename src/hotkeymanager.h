@@ -1,6 +1,7 @@
 #ifndef HOTKEYMANAGER_H
 #define HOTKEYMANAGER_H
 
+#include <QList>
 #include <QObject>
 #include <QString>
 #include <Qt>
@@ -19,11 +20,17 @@ public:
     void unregisterHotkey();
     bool isRegistered() const;
 
+    // modifiers + 1..count, for typing clipboard history entries
+    bool registerSlotHotkeys(int count, Qt::KeyboardModifiers modifiers);
+    void unregisterSlotHotkeys();
+    bool hasSlotHotkeys() const;
+
     void setEnabled(bool enabled);
     bool isEnabled() const;
 
 Q_SIGNALS:
     void hotkeyTriggered();
+    void slotTriggered(int slot);
     void registrationFailed(const QString& reason);
 
 private Q_SLOTS:
@@ -31,6 +38,7 @@ private Q_SLOTS:
 
 private:
     QAction* m_action;
+    QList<QAction*> m_slotActions;
     bool m_enabled;
     bool m_registered;
 };
@@ -0,0 +1,37 @@
+#ifndef INPUTBACKEND_H
+#define INPUTBACKEND_H
+
+#include <QString>
+
+#include <linux/input.h>
+
+// Sink for raw evdev events. A backend keeps its connection open between
+// pastes so the hot path is a plain write.
+class InputBackend
+{
+public:
+    virtual ~InputBackend() = default;
+
+    virtual QString name() const = 0;
+
+    virtual bool open() = 0;
+    virtual void close() = 0;
+    virtual bool isOpen() const = 0;
+
+    // Writes the events in order, blocking until all were accepted.
+    virtual bool writeEvents(const input_event* events, int count) = 0;
+
+    // How many events the typing loop hands over per call when it is not
+    // pacing. A cancel is noticed between calls, so smaller stops sooner.
+    virtual int preferredWriteSize() const { return 64; }
+
+    QString errorString() const { return m_errorString; }
+
+protected:
+    void setErrorString(const QString& error) { m_errorString = error; }
+
+private:
+    QString m_errorString;
+};
+
+#endif // INPUTBACKEND_H
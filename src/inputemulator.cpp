@@ -1,81 +1,71 @@
 #include "inputemulator.h"
+#include "typingworker.h"
 
 #include <QThread>
-#include <QDebug>
-#include <QProcess>
-#include <QProcessEnvironment>
-#include <QFile>
-#include <unistd.h>
 
 InputEmulator::InputEmulator(QObject* parent)
     : QObject(parent)
-    , m_cancelled(false)
+    , m_thread(new QThread(this))
+    , m_worker(new TypingWorker)
     , m_typing(false)
     , m_initialized(false)
-    , m_currentProcess(nullptr)
+    , m_initializing(false)
 {
+    qRegisterMetaType<PasteReport>();
+
+    m_thread->setObjectName(QStringLiteral("ClickPasteTyping"));
+    m_worker->moveToThread(m_thread);
+    connect(m_thread, &QThread::finished, m_worker, &QObject::deleteLater);
+
+    // Worker signals arrive queued on the GUI thread
+    connect(m_worker, &TypingWorker::initialized, this, [this](bool ok) {
+        m_initializing = false;
+        m_initialized = ok;
+        Q_EMIT initialized(ok);
+    });
+    connect(m_worker, &TypingWorker::typingStarted,
+            this, &InputEmulator::typingStarted);
+    connect(m_worker, &TypingWorker::typingPlanned,
+            this, &InputEmulator::typingPlanned);
+    connect(m_worker, &TypingWorker::typingProgress,
+            this, &InputEmulator::typingProgress);
+    connect(m_worker, &TypingWorker::typingPaused,
+            this, &InputEmulator::typingPaused);
+    connect(m_worker, &TypingWorker::typingResumed,
+            this, &InputEmulator::typingResumed);
+    connect(m_worker, &TypingWorker::sessionFinished,
+            this, &InputEmulator::sessionFinished);
+    connect(m_worker, &TypingWorker::typingFinished, this, [this]() {
+        m_typing = false;
+        Q_EMIT typingFinished();
+    });
+    connect(m_worker, &TypingWorker::typingCancelled, this, [this](qsizetype offset, int typed) {
+        m_typing = false;
+        Q_EMIT typingCancelled(offset, typed);
+    });
+    connect(m_worker, &TypingWorker::errorOccurred, this, [this](const QString& error) {
+        m_typing = false;
+        Q_EMIT errorOccurred(error);
+    });
+
+    m_thread->start();
 }
 
 InputEmulator::~InputEmulator()
 {
     cancel();
+    m_thread->quit();
+    m_thread->wait();
 }
 
-bool InputEmulator::initialize()
+void InputEmulator::initialize()
 {
-    if (m_initialized) {
-        return true;
-    }
-
-    // Check if ydotool is available
-    QProcess which;
-    which.start(QStringLiteral("which"), {QStringLiteral("ydotool")});
-    if (!which.waitForFinished(1000) || which.exitCode() != 0) {
-        Q_EMIT errorOccurred(QStringLiteral("ydotool not found. Please install: sudo pacman -S ydotool"));
-        return false;
-    }
-
-    // Strategy 1: Check for system socket (AUR/packaged install)
-    QString systemSocket = QStringLiteral("/run/ydotool/socket");
-    if (QFile::exists(systemSocket)) {
-        m_socketPath = systemSocket;
-        m_initialized = true;
-        qDebug() << "Using system ydotoold socket";
-        return true;
-    }
-
-    // Strategy 2: Fall back to user socket (development)
-    QString userSocket = QStringLiteral("/run/user/%1/.ydotool_socket").arg(getuid());
-
-    if (!QFile::exists(userSocket)) {
-        // Try to start ydotoold as user daemon
-        qDebug() << "Starting user ydotoold daemon for development...";
-
-        QProcess daemon;
-        daemon.setProgram(QStringLiteral("ydotoold"));
-        daemon.setArguments({QStringLiteral("--socket-path"), userSocket,
-                            QStringLiteral("--socket-perm"), QStringLiteral("0600")});
-        daemon.startDetached();
-
-        // Wait for it to start
-        QThread::msleep(500);
-    }
-
-    if (QFile::exists(userSocket)) {
-        m_socketPath = userSocket;
-        m_initialized = true;
-        qDebug() << "Using user ydotoold socket";
-        return true;
+    if (m_initialized || m_initializing) {
+        return;
     }
 
-    // Neither worked
-    Q_EMIT errorOccurred(QStringLiteral("Could not connect to ydotoold.\n\n"
-                                        "For development: Add yourself to 'input' group:\n"
-                                        "  sudo usermod -aG input $USER\n"
-                                        "  (then log out and back in)\n\n"
-                                        "For production: Enable the systemd service:\n"
-                                        "  sudo systemctl enable --now ydotoold.service"));
-    return false;
+    m_initializing = true;
+    QMetaObject::invokeMethod(m_worker, &TypingWorker::initialize, Qt::QueuedConnection);
 }
 
 bool InputEmulator::isInitialized() const
@@ -83,10 +73,10 @@ bool InputEmulator::isInitialized() const
     return m_initialized;
 }
 
-void InputEmulator::typeText(const QString& text, int keyDelayMs, int startDelayMs)
+void InputEmulator::typeText(const QByteArray& text, int characters, const TypingOptions& options)
 {
-    if (!m_initialized) {
-        Q_EMIT errorOccurred(QStringLiteral("Input emulator not initialized"));
+    if (!m_initialized && !m_initializing) {
+        Q_EMIT errorOccurred(QStringLiteral("No input backend available"));
         return;
     }
 
@@ -95,108 +85,61 @@ void InputEmulator::typeText(const QString& text, int keyDelayMs, int startDelay
         return;
     }
 
-    m_cancelled = false;
-    m_typing = true;
-    Q_EMIT typingStarted();
-
-    // Start delay
-    if (startDelayMs > 0) {
-        QThread::msleep(startDelayMs);
-    }
-
-    if (m_cancelled) {
-        m_typing = false;
-        Q_EMIT typingCancelled();
+    if (m_typing) {
         return;
     }
 
-    // Use ydotool for typing
-    // ydotool type --key-delay <ms> "text"
-    m_currentProcess = new QProcess(this);
+    m_typing = true;
+    m_worker->resetCancel();
 
-    // Set the socket path environment variable
-    QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
-    env.insert(QStringLiteral("YDOTOOL_SOCKET"), m_socketPath);
-    m_currentProcess->setProcessEnvironment(env);
+    QMetaObject::invokeMethod(m_worker, [worker = m_worker, text, characters, options]() {
+        worker->typeText(text, characters, options);
+    }, Qt::QueuedConnection);
+}
 
-    QStringList args;
-    args << QStringLiteral("type");
+void InputEmulator::typeFile(const QString& path, const TypingOptions& options, qsizetype from)
+{
+    if (!m_initialized && !m_initializing) {
+        Q_EMIT errorOccurred(QStringLiteral("No input backend available"));
+        return;
+    }
 
-    if (keyDelayMs > 0) {
-        args << QStringLiteral("--key-delay") << QString::number(keyDelayMs);
+    if (m_typing) {
+        return;
     }
 
-    args << QStringLiteral("--") << text;
+    m_typing = true;
+    m_worker->resetCancel();
 
-    m_currentProcess->start(QStringLiteral("ydotool"), args);
+    QMetaObject::invokeMethod(m_worker, [worker = m_worker, path, options, from]() {
+        worker->typeFile(path, options, from);
+    }, Qt::QueuedConnection);
+}
 
-    // Poll for completion, checking for cancellation
-    while (!m_currentProcess->waitForFinished(100)) {
-        if (m_cancelled) {
-            m_currentProcess->kill();
-            m_currentProcess->waitForFinished(1000);
-            break;
-        }
-    }
+void InputEmulator::cancel()
+{
+    // Goes straight to the worker, it wakes up from any pending delay
+    m_worker->cancel();
+}
 
-    bool wasCancelled = m_cancelled;
-    int exitCode = m_currentProcess->exitCode();
-    QString errorOutput = QString::fromUtf8(m_currentProcess->readAllStandardError());
-
-    delete m_currentProcess;
-    m_currentProcess = nullptr;
-    m_typing = false;
-
-    if (wasCancelled) {
-        Q_EMIT typingCancelled();
-    } else if (exitCode != 0) {
-        if (errorOutput.isEmpty()) {
-            errorOutput = QStringLiteral("ydotool failed. Is ydotoold running? Try: sudo systemctl start ydotoold");
-        }
-        Q_EMIT errorOccurred(errorOutput);
-    } else {
-        Q_EMIT typingFinished();
-    }
+bool InputEmulator::isTyping() const
+{
+    return m_typing;
 }
 
-void InputEmulator::cancel()
+void InputEmulator::pause()
 {
-    m_cancelled = true;
-    if (m_currentProcess && m_currentProcess->state() != QProcess::NotRunning) {
-        m_currentProcess->kill();
-        m_currentProcess->waitForFinished(500);
-
-        // Release any stuck keys by sending key releases for common keys
-        // This fixes keys getting "stuck" when killed mid-keystroke
-        releaseAllKeys();
+    if (m_typing) {
+        m_worker->pause();
     }
 }
 
-void InputEmulator::releaseAllKeys()
+void InputEmulator::resume()
 {
-    // Use ydotool to release modifier keys and spacebar that might be stuck
-    // Key codes: 42=LShift, 54=RShift, 29=LCtrl, 97=RCtrl, 56=LAlt, 100=RAlt, 57=Space
-    QProcess release;
-    QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
-    env.insert(QStringLiteral("YDOTOOL_SOCKET"), m_socketPath);
-    release.setProcessEnvironment(env);
-
-    // Send key-up events for common stuck keys
-    release.start(QStringLiteral("ydotool"), {
-        QStringLiteral("key"),
-        QStringLiteral("42:0"),  // LShift up
-        QStringLiteral("54:0"),  // RShift up
-        QStringLiteral("29:0"),  // LCtrl up
-        QStringLiteral("97:0"),  // RCtrl up
-        QStringLiteral("56:0"),  // LAlt up
-        QStringLiteral("100:0"), // RAlt up
-        QStringLiteral("57:0"),  // Space up
-        QStringLiteral("125:0"), // Super up
-    });
-    release.waitForFinished(1000);
+    m_worker->resume();
 }
 
-bool InputEmulator::isTyping() const
+bool InputEmulator::isPaused() const
 {
-    return m_typing;
+    return m_typing && m_worker->isPaused();
 }
@@ -1,12 +1,19 @@
 #ifndef INPUTEMULATOR_H
 #define INPUTEMULATOR_H
 
+#include "pastereport.h"
+#include "typingoptions.h"
+
+#include <QByteArray>
 #include <QObject>
 #include <QString>
 #include <atomic>
 
-class QProcess;
+class QThread;
+class TypingWorker;
 
+// GUI-side facade for the typing engine. All typing happens on a worker
+// thread, so none of these calls block the event loop.
 class InputEmulator : public QObject
 {
     Q_OBJECT
@@ -15,28 +22,43 @@ public:
     explicit InputEmulator(QObject* parent = nullptr);
     ~InputEmulator();
 
-    bool initialize();
+    // Starts backend discovery on the worker thread; initialized() follows.
+    // Pastes requested in the meantime run once it is done.
+    void initialize();
     bool isInitialized() const;
 
-    void typeText(const QString& text, int keyDelayMs, int startDelayMs = 0);
+    // text is normalized UTF-8, characters its length in code points
+    void typeText(const QByteArray& text, int characters, const TypingOptions& options);
+    // Types the file's contents, streamed from disk on the worker thread,
+    // starting from a typingCancelled() offset
+    void typeFile(const QString& path, const TypingOptions& options, qsizetype from = 0);
     void cancel();
     bool isTyping() const;
 
+    // Holds the current paste between two keystrokes
+    void pause();
+    void resume();
+    bool isPaused() const;
+
 Q_SIGNALS:
+    void initialized(bool ok);
     void typingStarted();
+    void typingPlanned(int slowPath, int skipped);
     void typingProgress(int current, int total);
+    void typingPaused(int current, int total);
+    void typingResumed();
     void typingFinished();
-    void typingCancelled();
+    // offset is the byte offset into the text of the first character not typed
+    void typingCancelled(qsizetype offset, int typed);
     void errorOccurred(const QString& error);
+    void sessionFinished(const PasteReport& report);
 
 private:
-    void releaseAllKeys();
-
-    std::atomic<bool> m_cancelled;
+    QThread* m_thread;
+    TypingWorker* m_worker;
     std::atomic<bool> m_typing;
     bool m_initialized;
-    QString m_socketPath;
-    QProcess* m_currentProcess;
+    bool m_initializing;
 };
 
 #endif // INPUTEMULATOR_H
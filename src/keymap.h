@@ -0,0 +1,136 @@
+#ifndef KEYMAP_H
+#define KEYMAP_H
+
+#include <QtGlobal>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <iterator>
+
+#include <linux/input-event-codes.h>
+
+// A single key press on a US QWERTY layout, which is what ydotool assumes too
+struct KeyStroke
+{
+    quint16 code = 0;
+    quint8 modifiers = 0;
+
+    constexpr bool isValid() const { return code != 0; }
+};
+
+namespace Keymap {
+
+enum Modifier : quint8 {
+    NoModifier = 0x0,
+    Shift = 0x1
+};
+
+// One physical key and the characters it produces without and with Shift
+struct KeyDef
+{
+    quint16 code;
+    char base;
+    char shifted;
+};
+
+constexpr KeyDef UsQwerty[] = {
+    {KEY_GRAVE, '`', '~'}, {KEY_1, '1', '!'}, {KEY_2, '2', '@'}, {KEY_3, '3', '#'},
+    {KEY_4, '4', '$'}, {KEY_5, '5', '%'}, {KEY_6, '6', '^'}, {KEY_7, '7', '&'},
+    {KEY_8, '8', '*'}, {KEY_9, '9', '('}, {KEY_0, '0', ')'}, {KEY_MINUS, '-', '_'},
+    {KEY_EQUAL, '=', '+'},
+    {KEY_Q, 'q', 'Q'}, {KEY_W, 'w', 'W'}, {KEY_E, 'e', 'E'}, {KEY_R, 'r', 'R'},
+    {KEY_T, 't', 'T'}, {KEY_Y, 'y', 'Y'}, {KEY_U, 'u', 'U'}, {KEY_I, 'i', 'I'},
+    {KEY_O, 'o', 'O'}, {KEY_P, 'p', 'P'}, {KEY_LEFTBRACE, '[', '{'},
+    {KEY_RIGHTBRACE, ']', '}'}, {KEY_BACKSLASH, '\\', '|'},
+    {KEY_A, 'a', 'A'}, {KEY_S, 's', 'S'}, {KEY_D, 'd', 'D'}, {KEY_F, 'f', 'F'},
+    {KEY_G, 'g', 'G'}, {KEY_H, 'h', 'H'}, {KEY_J, 'j', 'J'}, {KEY_K, 'k', 'K'},
+    {KEY_L, 'l', 'L'}, {KEY_SEMICOLON, ';', ':'}, {KEY_APOSTROPHE, '\'', '"'},
+    {KEY_Z, 'z', 'Z'}, {KEY_X, 'x', 'X'}, {KEY_C, 'c', 'C'}, {KEY_V, 'v', 'V'},
+    {KEY_B, 'b', 'B'}, {KEY_N, 'n', 'N'}, {KEY_M, 'm', 'M'}, {KEY_COMMA, ',', '<'},
+    {KEY_DOT, '.', '>'}, {KEY_SLASH, '/', '?'},
+    {KEY_SPACE, ' ', 0}, {KEY_ENTER, '\n', 0}, {KEY_TAB, '\t', 0},
+};
+
+using AsciiTable = std::array<KeyStroke, 128>;
+
+template <std::size_t N>
+constexpr AsciiTable makeAsciiTable(const KeyDef (&keys)[N])
+{
+    AsciiTable table = {};
+    for (std::size_t i = 0; i < N; ++i) {
+        table[static_cast<unsigned char>(keys[i].base)] = KeyStroke{keys[i].code, NoModifier};
+        if (keys[i].shifted) {
+            table[static_cast<unsigned char>(keys[i].shifted)] = KeyStroke{keys[i].code, Shift};
+        }
+    }
+    return table;
+}
+
+inline constexpr AsciiTable Ascii = makeAsciiTable(UsQwerty);
+
+// Returns an invalid stroke for characters that have no key on the layout
+constexpr KeyStroke lookup(char32_t ch)
+{
+    return ch < Ascii.size() ? Ascii[ch] : KeyStroke{};
+}
+
+static_assert(lookup(U'a').code == KEY_A && lookup(U'a').modifiers == NoModifier);
+static_assert(lookup(U'A').code == KEY_A && lookup(U'A').modifiers == Shift);
+static_assert(lookup(U'\n').code == KEY_ENTER);
+static_assert(!lookup(U'\r').isValid());
+
+// Compose key sequences from the stock X11/xkb en_US.UTF-8 Compose table,
+// for characters that come up in ordinary prose and docs
+struct ComposeDef
+{
+    char32_t ch;
+    char keys[4];
+};
+
+constexpr ComposeDef Compose[] = {
+    {0x00A1, "!!"}, {0x00A2, "c|"}, {0x00A3, "L-"}, {0x00A5, "Y="}, {0x00A7, "so"},
+    {0x00A9, "oc"}, {0x00AB, "<<"}, {0x00AE, "or"}, {0x00B0, "oo"}, {0x00B1, "+-"},
+    {0x00B7, ".-"}, {0x00BB, ">>"}, {0x00BC, "14"}, {0x00BD, "12"}, {0x00BE, "34"},
+    {0x00BF, "??"},
+    {0x00C0, "`A"}, {0x00C1, "'A"}, {0x00C2, "^A"}, {0x00C3, "~A"}, {0x00C4, "\"A"},
+    {0x00C5, "oA"}, {0x00C6, "AE"}, {0x00C7, ",C"}, {0x00C8, "`E"}, {0x00C9, "'E"},
+    {0x00CA, "^E"}, {0x00CB, "\"E"}, {0x00CC, "`I"}, {0x00CD, "'I"}, {0x00CE, "^I"},
+    {0x00CF, "\"I"}, {0x00D1, "~N"}, {0x00D2, "`O"}, {0x00D3, "'O"}, {0x00D4, "^O"},
+    {0x00D5, "~O"}, {0x00D6, "\"O"}, {0x00D7, "xx"}, {0x00D8, "/O"}, {0x00D9, "`U"},
+    {0x00DA, "'U"}, {0x00DB, "^U"}, {0x00DC, "\"U"}, {0x00DD, "'Y"}, {0x00DF, "ss"},
+    {0x00E0, "`a"}, {0x00E1, "'a"}, {0x00E2, "^a"}, {0x00E3, "~a"}, {0x00E4, "\"a"},
+    {0x00E5, "oa"}, {0x00E6, "ae"}, {0x00E7, ",c"}, {0x00E8, "`e"}, {0x00E9, "'e"},
+    {0x00EA, "^e"}, {0x00EB, "\"e"}, {0x00EC, "`i"}, {0x00ED, "'i"}, {0x00EE, "^i"},
+    {0x00EF, "\"i"}, {0x00F1, "~n"}, {0x00F2, "`o"}, {0x00F3, "'o"}, {0x00F4, "^o"},
+    {0x00F5, "~o"}, {0x00F6, "\"o"}, {0x00F7, ":-"}, {0x00F8, "/o"}, {0x00F9, "`u"},
+    {0x00FA, "'u"}, {0x00FB, "^u"}, {0x00FC, "\"u"}, {0x00FD, "'y"}, {0x00FF, "\"y"},
+    {0x2013, "--."}, {0x2014, "---"}, {0x2018, "<'"}, {0x2019, ">'"}, {0x201A, ",'"},
+    {0x201C, "<\""}, {0x201D, ">\""}, {0x201E, ",\""}, {0x2022, ".="}, {0x2026, ".."},
+    {0x20AC, "=e"}, {0x2122, "tm"},
+};
+
+constexpr bool isSorted(const ComposeDef* begin, const ComposeDef* end)
+{
+    for (const ComposeDef* p = begin + 1; p < end; ++p) {
+        if ((p - 1)->ch >= p->ch) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert(isSorted(std::begin(Compose), std::end(Compose)), "composeSequence() does a binary search");
+
+// Returns the keys to press after Compose, or nullptr if there is no sequence
+inline const char* composeSequence(char32_t ch)
+{
+    const ComposeDef* end = std::end(Compose);
+    const ComposeDef* it = std::lower_bound(std::begin(Compose), end, ch,
+                                            [](const ComposeDef& def, char32_t c) { return def.ch < c; });
+    return it != end && it->ch == ch ? it->keys : nullptr;
+}
+
+} // namespace Keymap
+
+#endif // KEYMAP_H
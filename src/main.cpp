@@ -1,10 +1,20 @@
 #include "application.h"
+#include "commandclient.h"
 
 #include <QApplication>
+#include <QCommandLineParser>
 #include <QDebug>
+#include <QFile>
+#include <QTimer>
 
 int main(int argc, char* argv[])
 {
+    // Commands for a running instance are sent before any GUI start-up
+    const int forwarded = CommandClient::forward(argc, argv);
+    if (forwarded >= 0) {
+        return forwarded;
+    }
+
     // Set application metadata
     QApplication::setApplicationName(QStringLiteral("ClickPaste"));
     QApplication::setApplicationVersion(QStringLiteral("1.0.0"));
@@ -18,6 +28,25 @@ int main(int argc, char* argv[])
     // Don't quit when last window closes (we're a tray app)
     app.setQuitOnLastWindowClosed(false);
 
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Types the clipboard as keystrokes"));
+    parser.addHelpOption();
+    parser.addVersionOption();
+    const QCommandLineOption typeFileOption(QStringLiteral("type-file"),
+                                            QStringLiteral("Type the contents of <file> into the focused window."),
+                                            QStringLiteral("file"));
+    parser.addOption(typeFileOption);
+    const QCommandLineOption typeTextOption(QStringLiteral("type-text"),
+                                            QStringLiteral("Type <text> into the focused window, - reads it from standard input."),
+                                            QStringLiteral("text"));
+    parser.addOption(typeTextOption);
+    // Handled by CommandClient; listed for --help
+    parser.addOption(QCommandLineOption(QStringLiteral("cancel"),
+                                        QStringLiteral("Cancel the paste a running instance is typing.")));
+    parser.addOption(QCommandLineOption(QStringLiteral("status"),
+                                        QStringLiteral("Print whether a running instance is idle, typing or paused.")));
+    parser.process(app);
+
     // Create and initialize the application
     Application clickPaste;
     if (!clickPaste.initialize()) {
@@ -25,5 +54,24 @@ int main(int argc, char* argv[])
         return 1;
     }
 
+    // Queued behind the rest of the startup, which also runs from the event loop
+    if (parser.isSet(typeFileOption)) {
+        const QString path = parser.value(typeFileOption);
+        QTimer::singleShot(0, &clickPaste, [&clickPaste, path]() {
+            clickPaste.typeFile(path);
+        });
+    }
+    if (parser.isSet(typeTextOption)) {
+        QByteArray text = parser.value(typeTextOption).toUtf8();
+        if (text == "-") {
+            QFile input;
+            input.open(stdin, QIODevice::ReadOnly);
+            text = input.readAll();
+        }
+        QTimer::singleShot(0, &clickPaste, [&clickPaste, text]() {
+            clickPaste.typeText(text);
+        });
+    }
+
     return app.exec();
 }
@@ -0,0 +1,159 @@
+#include "pacer.h"
+
+#include <QDebug>
+
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace {
+constexpr qint64 NsPerSec = 1000000000;
+
+// Low enough not to compete with audio or the compositor
+constexpr int RealtimePriority = 10;
+}
+
+Pacer::Pacer()
+    : m_timerFd(::timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC))
+    , m_wakeFd(::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK))
+    , m_deadline(0)
+{
+    if (m_timerFd < 0 || m_wakeFd < 0) {
+        qWarning() << "Pacer: could not create timer:" << strerror(errno);
+    }
+}
+
+Pacer::~Pacer()
+{
+    if (m_timerFd >= 0) {
+        ::close(m_timerFd);
+    }
+    if (m_wakeFd >= 0) {
+        ::close(m_wakeFd);
+    }
+}
+
+bool Pacer::isValid() const
+{
+    return m_timerFd >= 0 && m_wakeFd >= 0;
+}
+
+qint64 Pacer::now()
+{
+    timespec ts;
+    ::clock_gettime(CLOCK_MONOTONIC, &ts);
+    return qint64(ts.tv_sec) * NsPerSec + ts.tv_nsec;
+}
+
+void Pacer::start(qint64 delayNs)
+{
+    m_deadline = now() + qMax<qint64>(delayNs, 0);
+}
+
+void Pacer::advance(qint64 intervalNs)
+{
+    m_deadline += intervalNs;
+
+    const qint64 earliest = now() + intervalNs / 2;
+    if (m_deadline < earliest) {
+        m_deadline = earliest;
+    }
+}
+
+bool Pacer::wait()
+{
+    pollfd fds[2];
+    fds[0].fd = m_timerFd;
+    fds[0].events = POLLIN;
+    fds[1].fd = m_wakeFd;
+    fds[1].events = POLLIN;
+
+    if (!isValid()) {
+        // No timerfd; still sleep to the deadline, just not interruptibly
+        timespec ts;
+        ts.tv_sec = m_deadline / NsPerSec;
+        ts.tv_nsec = m_deadline % NsPerSec;
+        while (::clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {
+        }
+        return true;
+    }
+
+    if (m_deadline <= now()) {
+        // Already due, just check for an interrupt
+        return ::poll(&fds[1], 1, 0) == 0;
+    }
+
+    itimerspec spec;
+    std::memset(&spec, 0, sizeof(spec));
+    spec.it_value.tv_sec = m_deadline / NsPerSec;
+    spec.it_value.tv_nsec = m_deadline % NsPerSec;
+    if (::timerfd_settime(m_timerFd, TFD_TIMER_ABSTIME, &spec, nullptr) != 0) {
+        qWarning() << "Pacer: timerfd_settime failed:" << strerror(errno);
+        return false;
+    }
+
+    for (;;) {
+        const int result = ::poll(fds, 2, -1);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+
+        if (fds[1].revents & POLLIN) {
+            return false;
+        }
+
+        if (fds[0].revents & POLLIN) {
+            quint64 expirations;
+            if (::read(m_timerFd, &expirations, sizeof(expirations)) < 0 && errno == EAGAIN) {
+                continue;
+            }
+            return true;
+        }
+    }
+}
+
+void Pacer::interrupt()
+{
+    const quint64 one = 1;
+    if (m_wakeFd >= 0 && ::write(m_wakeFd, &one, sizeof(one)) < 0) {
+        qWarning() << "Pacer: could not interrupt:" << strerror(errno);
+    }
+}
+
+void Pacer::clearInterrupt()
+{
+    quint64 value;
+    while (m_wakeFd >= 0 && ::read(m_wakeFd, &value, sizeof(value)) > 0) {
+    }
+}
+
+bool Pacer::setRealtime(bool enabled)
+{
+    sched_param param;
+    std::memset(&param, 0, sizeof(param));
+
+    if (!enabled) {
+        return ::pthread_setschedparam(::pthread_self(), SCHED_OTHER, &param) == 0;
+    }
+
+    param.sched_priority = RealtimePriority;
+    const int error = ::pthread_setschedparam(::pthread_self(), SCHED_FIFO, &param);
+    if (error != 0) {
+        qWarning() << "Pacer: could not enable realtime scheduling:" << strerror(error);
+        return false;
+    }
+
+    // Memory is left unlocked: mlockall() would cover the whole GUI process
+    // and, with MCL_FUTURE, make allocations fail past RLIMIT_MEMLOCK. The
+    // event buffer is reserved when a paste begins, so faults are rare.
+    return true;
+}
@@ -0,0 +1,47 @@
+#ifndef PACER_H
+#define PACER_H
+
+#include <QtGlobal>
+
+// Schedules keystrokes on absolute CLOCK_MONOTONIC deadlines through a
+// timerfd, so time spent writing events does not accumulate as drift.
+// Waits can be interrupted immediately from any thread.
+class Pacer
+{
+public:
+    Pacer();
+    ~Pacer();
+
+    Pacer(const Pacer&) = delete;
+    Pacer& operator=(const Pacer&) = delete;
+
+    bool isValid() const;
+
+    // Sets the first deadline delayNs from now
+    void start(qint64 delayNs);
+
+    // Moves the deadline intervalNs further. If we are running late, the
+    // next gap is never shortened below half the interval.
+    void advance(qint64 intervalNs);
+
+    // Blocks until the deadline. Returns false if interrupted.
+    bool wait();
+
+    // Thread-safe. Makes the current and all further wait()s return false
+    // until clearInterrupt() is called.
+    void interrupt();
+    void clearInterrupt();
+
+    // Switches the calling thread to SCHED_FIFO, or back to normal
+    // scheduling. Needs CAP_SYS_NICE or an RLIMIT_RTPRIO.
+    static bool setRealtime(bool enabled);
+
+    static qint64 now();
+
+private:
+    int m_timerFd;
+    int m_wakeFd;
+    qint64 m_deadline;
+};
+
+#endif // PACER_H
@@ -0,0 +1,137 @@
+#include "pastemetrics.h"
+
+#include <QStringList>
+
+namespace {
+// Per-paste metrics cover roughly the last this many pastes
+constexpr quint64 SessionWindow = 100;
+// Jitter has one sample per key
+constexpr quint64 JitterWindow = 10000;
+
+constexpr double NsPerUs = 1000.0;
+constexpr qint64 NsPerSecond = 1000000000;
+
+QVariantMap describe(const RollingHistogram& histogram, double divisor)
+{
+    QVariantMap map;
+    map.insert(QStringLiteral("count"), histogram.count());
+    map.insert(QStringLiteral("p50"), histogram.percentile(0.50) / divisor);
+    map.insert(QStringLiteral("p90"), histogram.percentile(0.90) / divisor);
+    map.insert(QStringLiteral("p99"), histogram.percentile(0.99) / divisor);
+    map.insert(QStringLiteral("max"), histogram.max() / divisor);
+    return map;
+}
+
+QString describeLine(const QString& label, const RollingHistogram& histogram,
+                     double divisor, const QString& unit)
+{
+    if (histogram.count() == 0) {
+        return QStringLiteral("%1: no data").arg(label);
+    }
+    return QStringLiteral("%1: p50 %2, p90 %3, p99 %4, max %5 %6")
+        .arg(label)
+        .arg(histogram.percentile(0.50) / divisor, 0, 'f', 1)
+        .arg(histogram.percentile(0.90) / divisor, 0, 'f', 1)
+        .arg(histogram.percentile(0.99) / divisor, 0, 'f', 1)
+        .arg(histogram.max() / divisor, 0, 'f', 1)
+        .arg(unit);
+}
+}
+
+PasteMetrics::PasteMetrics(QObject* parent)
+    : QObject(parent)
+    , m_clipboardFetch(SessionWindow)
+    , m_encode(SessionWindow)
+    , m_firstKey(SessionWindow)
+    , m_charsPerSecond(SessionWindow)
+    , m_jitter(JitterWindow)
+    , m_cancelLatency(SessionWindow)
+    , m_sessions(0)
+    , m_cancelled(0)
+{
+}
+
+bool PasteMetrics::registerOn(QDBusConnection connection)
+{
+    return connection.registerObject(QStringLiteral("/Metrics"), this,
+                                     QDBusConnection::ExportScriptableContents);
+}
+
+void PasteMetrics::recordSession(const PasteReport& report)
+{
+    ++m_sessions;
+
+    m_clipboardFetch.record(report.clipboardFetchNs);
+    m_encode.record(report.encodeNs);
+
+    if (report.firstKeyNs > 0 && report.requestedNs > 0) {
+        // The start delay is a setting, not latency
+        m_firstKey.record(report.firstKeyNs - report.requestedNs - report.startDelayNs);
+    }
+
+    const qint64 typingNs = report.finishedNs - report.firstKeyNs;
+    if (report.firstKeyNs > 0 && report.characters > 1 && typingNs > 0) {
+        m_charsPerSecond.record(qint64(report.characters) * NsPerSecond / typingNs);
+    }
+
+    m_jitter.merge(report.jitterNs);
+
+    if (report.cancelled) {
+        ++m_cancelled;
+        if (report.cancelLatencyNs > 0) {
+            m_cancelLatency.record(report.cancelLatencyNs);
+        }
+    }
+
+    Q_EMIT sessionRecorded();
+}
+
+int PasteMetrics::sessionCount() const
+{
+    return m_sessions;
+}
+
+int PasteMetrics::cancelledCount() const
+{
+    return m_cancelled;
+}
+
+QVariantMap PasteMetrics::summary() const
+{
+    QVariantMap map;
+    map.insert(QStringLiteral("sessions"), m_sessions);
+    map.insert(QStringLiteral("cancelled"), m_cancelled);
+    map.insert(QStringLiteral("clipboardFetchUs"), describe(m_clipboardFetch, NsPerUs));
+    map.insert(QStringLiteral("encodeUs"), describe(m_encode, NsPerUs));
+    map.insert(QStringLiteral("timeToFirstKeyUs"), describe(m_firstKey, NsPerUs));
+    map.insert(QStringLiteral("charsPerSecond"), describe(m_charsPerSecond, 1.0));
+    map.insert(QStringLiteral("jitterUs"), describe(m_jitter, NsPerUs));
+    map.insert(QStringLiteral("cancelLatencyUs"), describe(m_cancelLatency, NsPerUs));
+    return map;
+}
+
+QString PasteMetrics::summaryText() const
+{
+    const double nsPerMs = 1000000.0;
+    const QString ms = QStringLiteral("ms");
+
+    QStringList lines;
+    lines << QStringLiteral("Pastes: %1 (%2 cancelled)").arg(m_sessions).arg(m_cancelled);
+    lines << describeLine(QStringLiteral("Clipboard fetch"), m_clipboardFetch, nsPerMs, ms);
+    lines << describeLine(QStringLiteral("Encoding"), m_encode, nsPerMs, ms);
+    lines << describeLine(QStringLiteral("Time to first key"), m_firstKey, nsPerMs, ms);
+    lines << describeLine(QStringLiteral("Speed"), m_charsPerSecond, 1.0, QStringLiteral("chars/s"));
+    lines << describeLine(QStringLiteral("Key timing jitter"), m_jitter, nsPerMs, ms);
+    lines << describeLine(QStringLiteral("Cancel latency"), m_cancelLatency, nsPerMs, ms);
+    return lines.join(QLatin1Char('\n'));
+}
+
+void PasteMetrics::reset()
+{
+    for (RollingHistogram* histogram : {&m_clipboardFetch, &m_encode, &m_firstKey,
+                                        &m_charsPerSecond, &m_jitter, &m_cancelLatency}) {
+        histogram->clear();
+    }
+    m_sessions = 0;
+    m_cancelled = 0;
+}
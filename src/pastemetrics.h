@@ -0,0 +1,53 @@
+#ifndef PASTEMETRICS_H
+#define PASTEMETRICS_H
+
+#include "histogram.h"
+#include "pastereport.h"
+
+#include <QDBusConnection>
+#include <QObject>
+#include <QString>
+#include <QVariantMap>
+
+// Rolling statistics over recent pastes. Exported on D-Bus as
+// app.clickpaste.Metrics at /Metrics on whatever connection it is
+// registered on, e.g.
+//   qdbus app.clickpaste.ClickPaste /Metrics summaryText
+class PasteMetrics : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "app.clickpaste.Metrics")
+    Q_PROPERTY(int sessionCount READ sessionCount)
+    Q_PROPERTY(int cancelledCount READ cancelledCount)
+
+public:
+    explicit PasteMetrics(QObject* parent = nullptr);
+
+    bool registerOn(QDBusConnection connection);
+
+    void recordSession(const PasteReport& report);
+
+    int sessionCount() const;
+    int cancelledCount() const;
+
+public Q_SLOTS:
+    // Per metric: count, p50, p90, p99 and max. Times in microseconds.
+    Q_SCRIPTABLE QVariantMap summary() const;
+    Q_SCRIPTABLE QString summaryText() const;
+    Q_SCRIPTABLE void reset();
+
+Q_SIGNALS:
+    Q_SCRIPTABLE void sessionRecorded();
+
+private:
+    RollingHistogram m_clipboardFetch;
+    RollingHistogram m_encode;
+    RollingHistogram m_firstKey;
+    RollingHistogram m_charsPerSecond;
+    RollingHistogram m_jitter;
+    RollingHistogram m_cancelLatency;
+    int m_sessions;
+    int m_cancelled;
+};
+
+#endif // PASTEMETRICS_H
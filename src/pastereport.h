@@ -0,0 +1,34 @@
+#ifndef PASTEREPORT_H
+#define PASTEREPORT_H
+
+#include "histogram.h"
+
+#include <QMetaType>
+
+// Timings of one paste. All timestamps are CLOCK_MONOTONIC nanoseconds
+// (Pacer::now()), 0 when the event did not happen.
+struct PasteReport
+{
+    // Filled in by Application
+    qint64 requestedNs = 0;
+    qint64 clipboardFetchNs = 0;
+    qint64 startDelayNs = 0;
+
+    // Filled in by TypingWorker
+    qint64 startedNs = 0;
+    qint64 firstKeyNs = 0;
+    qint64 finishedNs = 0;
+    qint64 encodeNs = 0;
+    qint64 cancelLatencyNs = 0;
+    int characters = 0;
+    int slowPathCharacters = 0;
+    int skippedCharacters = 0;
+    bool cancelled = false;
+
+    // Deviation of each paced gap from the configured one
+    Histogram jitterNs;
+};
+
+Q_DECLARE_METATYPE(PasteReport)
+
+#endif // PASTEREPORT_H
@@ -1,5 +1,32 @@
 #include "settings.h"
 
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QTimer>
+#include <QVariant>
+
+namespace {
+// Editors save in several steps; reload once they are done
+constexpr int ReloadDelayMs = 200;
+
+// QSettings keeps enums and flags as plain ints
+template<typename T>
+QVariant storedValue(const T& value)
+{
+    return QVariant::fromValue(value);
+}
+
+QVariant storedValue(Settings::HotkeyMode mode)
+{
+    return static_cast<int>(mode);
+}
+
+QVariant storedValue(Qt::KeyboardModifiers modifiers)
+{
+    return static_cast<int>(modifiers);
+}
+}
+
 Settings* Settings::s_instance = nullptr;
 
 Settings* Settings::instance()
@@ -13,103 +40,289 @@ Settings* Settings::instance()
 Settings::Settings(QObject* parent)
     : QObject(parent)
     , m_settings(QStringLiteral("ClickPaste"), QStringLiteral("ClickPaste"))
+    , m_watcher(new QFileSystemWatcher(this))
+    , m_reloadTimer(new QTimer(this))
+{
+    publish(load());
+
+    m_reloadTimer->setSingleShot(true);
+    m_reloadTimer->setInterval(ReloadDelayMs);
+    connect(m_reloadTimer, &QTimer::timeout, this, &Settings::reload);
+
+    connect(m_watcher, &QFileSystemWatcher::fileChanged, this, &Settings::onConfigFileChanged);
+    connect(m_watcher, &QFileSystemWatcher::directoryChanged, this, &Settings::onConfigFileChanged);
+    watchConfigFile();
+}
+
+Settings::~Settings() = default;
+
+bool Settings::Snapshot::operator==(const Snapshot& other) const
+{
+    return keyDelayMs == other.keyDelayMs
+        && startDelayMs == other.startDelayMs
+        && realtimePacing == other.realtimePacing
+        && burstEnabled == other.burstEnabled
+        && burstSize == other.burstSize
+        && burstGapMs == other.burstGapMs
+        && confirmEnabled == other.confirmEnabled
+        && confirmThreshold == other.confirmThreshold
+        && hotkey == other.hotkey
+        && hotkeyModifiers == other.hotkeyModifiers
+        && hotkeyMode == other.hotkeyMode
+        && historyHotkeysEnabled == other.historyHotkeysEnabled
+        && historyMemoryKiB == other.historyMemoryKiB
+        && unicodeHexEntry == other.unicodeHexEntry
+        && composeKey == other.composeKey
+        && coalesceModifiers == other.coalesceModifiers;
+}
+
+Settings::Snapshot Settings::load()
 {
+    const Snapshot defaults;
+    Snapshot s;
+    s.keyDelayMs = m_settings.value(QStringLiteral("keyDelayMs"), defaults.keyDelayMs).toInt();
+    s.startDelayMs = m_settings.value(QStringLiteral("startDelayMs"), defaults.startDelayMs).toInt();
+    s.realtimePacing = m_settings.value(QStringLiteral("realtimePacing"), defaults.realtimePacing).toBool();
+    s.burstEnabled = m_settings.value(QStringLiteral("burstEnabled"), defaults.burstEnabled).toBool();
+    s.burstSize = m_settings.value(QStringLiteral("burstSize"), defaults.burstSize).toInt();
+    s.burstGapMs = m_settings.value(QStringLiteral("burstGapMs"), defaults.burstGapMs).toInt();
+    s.confirmEnabled = m_settings.value(QStringLiteral("confirmEnabled"), defaults.confirmEnabled).toBool();
+    s.confirmThreshold = m_settings.value(QStringLiteral("confirmThreshold"), defaults.confirmThreshold).toInt();
+    s.hotkey = m_settings.value(QStringLiteral("hotkey"), defaults.hotkey).toString();
+    s.hotkeyModifiers = static_cast<Qt::KeyboardModifiers>(
+        m_settings.value(QStringLiteral("hotkeyModifiers"), static_cast<int>(defaults.hotkeyModifiers)).toInt());
+    s.hotkeyMode = static_cast<HotkeyMode>(
+        m_settings.value(QStringLiteral("hotkeyMode"), static_cast<int>(defaults.hotkeyMode)).toInt());
+    s.historyHotkeysEnabled = m_settings.value(QStringLiteral("historyHotkeysEnabled"), defaults.historyHotkeysEnabled).toBool();
+    s.historyMemoryKiB = m_settings.value(QStringLiteral("historyMemoryKiB"), defaults.historyMemoryKiB).toInt();
+    s.unicodeHexEntry = m_settings.value(QStringLiteral("unicodeHexEntry"), defaults.unicodeHexEntry).toBool();
+    s.composeKey = m_settings.value(QStringLiteral("composeKey"), defaults.composeKey).toInt();
+    s.coalesceModifiers = m_settings.value(QStringLiteral("coalesceModifiers"), defaults.coalesceModifiers).toBool();
+    return s;
+}
+
+void Settings::publish(const Snapshot& next)
+{
+    m_snapshot = std::make_shared<const Snapshot>(next);
+}
+
+template<typename T>
+void Settings::update(const char* key, T Snapshot::*field, const T& value, void (Settings::*changed)())
+{
+    const SnapshotPtr current = snapshot();
+    if ((*current).*field == value) {
+        return;
+    }
+
+    m_settings.setValue(QLatin1String(key), storedValue(value));
+    Snapshot next = *current;
+    next.*field = value;
+    publish(next);
+    Q_EMIT (this->*changed)();
 }
 
 int Settings::keyDelayMs() const
 {
-    return m_settings.value(QStringLiteral("keyDelayMs"), 15).toInt();
+    return snapshot()->keyDelayMs;
 }
 
 void Settings::setKeyDelayMs(int ms)
 {
-    if (keyDelayMs() != ms) {
-        m_settings.setValue(QStringLiteral("keyDelayMs"), ms);
-        Q_EMIT settingsChanged();
-    }
+    update("keyDelayMs", &Snapshot::keyDelayMs, ms);
 }
 
 int Settings::startDelayMs() const
 {
-    return m_settings.value(QStringLiteral("startDelayMs"), 0).toInt();
+    return snapshot()->startDelayMs;
 }
 
 void Settings::setStartDelayMs(int ms)
 {
-    if (startDelayMs() != ms) {
-        m_settings.setValue(QStringLiteral("startDelayMs"), ms);
-        Q_EMIT settingsChanged();
-    }
+    update("startDelayMs", &Snapshot::startDelayMs, ms);
+}
+
+bool Settings::realtimePacing() const
+{
+    return snapshot()->realtimePacing;
+}
+
+void Settings::setRealtimePacing(bool enabled)
+{
+    update("realtimePacing", &Snapshot::realtimePacing, enabled);
+}
+
+bool Settings::burstEnabled() const
+{
+    return snapshot()->burstEnabled;
+}
+
+void Settings::setBurstEnabled(bool enabled)
+{
+    update("burstEnabled", &Snapshot::burstEnabled, enabled);
+}
+
+int Settings::burstSize() const
+{
+    return snapshot()->burstSize;
+}
+
+void Settings::setBurstSize(int keys)
+{
+    update("burstSize", &Snapshot::burstSize, keys);
+}
+
+int Settings::burstGapMs() const
+{
+    return snapshot()->burstGapMs;
+}
+
+void Settings::setBurstGapMs(int ms)
+{
+    update("burstGapMs", &Snapshot::burstGapMs, ms);
 }
 
 bool Settings::confirmEnabled() const
 {
-    return m_settings.value(QStringLiteral("confirmEnabled"), false).toBool();
+    return snapshot()->confirmEnabled;
 }
 
 void Settings::setConfirmEnabled(bool enabled)
 {
-    if (confirmEnabled() != enabled) {
-        m_settings.setValue(QStringLiteral("confirmEnabled"), enabled);
-        Q_EMIT settingsChanged();
-    }
+    update("confirmEnabled", &Snapshot::confirmEnabled, enabled);
 }
 
 int Settings::confirmThreshold() const
 {
-    return m_settings.value(QStringLiteral("confirmThreshold"), 100).toInt();
+    return snapshot()->confirmThreshold;
 }
 
 void Settings::setConfirmThreshold(int chars)
 {
-    if (confirmThreshold() != chars) {
-        m_settings.setValue(QStringLiteral("confirmThreshold"), chars);
-        Q_EMIT settingsChanged();
-    }
+    update("confirmThreshold", &Snapshot::confirmThreshold, chars);
 }
 
 QString Settings::hotkey() const
 {
-    return m_settings.value(QStringLiteral("hotkey"), QStringLiteral("V")).toString();
+    return snapshot()->hotkey;
 }
 
 void Settings::setHotkey(const QString& key)
 {
-    if (hotkey() != key) {
-        m_settings.setValue(QStringLiteral("hotkey"), key);
-        Q_EMIT hotkeyChanged();
-    }
+    update("hotkey", &Snapshot::hotkey, key, &Settings::hotkeyChanged);
 }
 
 Qt::KeyboardModifiers Settings::hotkeyModifiers() const
 {
-    int mods = m_settings.value(QStringLiteral("hotkeyModifiers"),
-                                 static_cast<int>(Qt::ControlModifier | Qt::AltModifier)).toInt();
-    return static_cast<Qt::KeyboardModifiers>(mods);
+    return snapshot()->hotkeyModifiers;
 }
 
 void Settings::setHotkeyModifiers(Qt::KeyboardModifiers mods)
 {
-    if (hotkeyModifiers() != mods) {
-        m_settings.setValue(QStringLiteral("hotkeyModifiers"), static_cast<int>(mods));
-        Q_EMIT hotkeyChanged();
-    }
+    update("hotkeyModifiers", &Snapshot::hotkeyModifiers, mods, &Settings::hotkeyChanged);
 }
 
 Settings::HotkeyMode Settings::hotkeyMode() const
 {
-    return static_cast<HotkeyMode>(m_settings.value(QStringLiteral("hotkeyMode"), 0).toInt());
+    return snapshot()->hotkeyMode;
 }
 
 void Settings::setHotkeyMode(HotkeyMode mode)
 {
-    if (hotkeyMode() != mode) {
-        m_settings.setValue(QStringLiteral("hotkeyMode"), static_cast<int>(mode));
-        Q_EMIT settingsChanged();
-    }
+    update("hotkeyMode", &Snapshot::hotkeyMode, mode);
+}
+
+bool Settings::historyHotkeysEnabled() const
+{
+    return snapshot()->historyHotkeysEnabled;
+}
+
+void Settings::setHistoryHotkeysEnabled(bool enabled)
+{
+    update("historyHotkeysEnabled", &Snapshot::historyHotkeysEnabled, enabled);
+}
+
+int Settings::historyMemoryKiB() const
+{
+    return snapshot()->historyMemoryKiB;
+}
+
+void Settings::setHistoryMemoryKiB(int kib)
+{
+    update("historyMemoryKiB", &Snapshot::historyMemoryKiB, kib);
+}
+
+bool Settings::unicodeHexEntry() const
+{
+    return snapshot()->unicodeHexEntry;
+}
+
+void Settings::setUnicodeHexEntry(bool enabled)
+{
+    update("unicodeHexEntry", &Snapshot::unicodeHexEntry, enabled);
+}
+
+int Settings::composeKey() const
+{
+    return snapshot()->composeKey;
+}
+
+void Settings::setComposeKey(int code)
+{
+    update("composeKey", &Snapshot::composeKey, code);
+}
+
+bool Settings::coalesceModifiers() const
+{
+    return snapshot()->coalesceModifiers;
+}
+
+void Settings::setCoalesceModifiers(bool enabled)
+{
+    update("coalesceModifiers", &Snapshot::coalesceModifiers, enabled);
 }
 
 void Settings::sync()
 {
     m_settings.sync();
 }
+
+void Settings::watchConfigFile()
+{
+    // Saving usually replaces the file, which drops the watch on it; the
+    // directory watch notices the new one
+    const QString file = m_settings.fileName();
+    const QString dir = QFileInfo(file).absolutePath();
+    if (!m_watcher->directories().contains(dir)) {
+        m_watcher->addPath(dir);
+    }
+    if (QFileInfo::exists(file) && !m_watcher->files().contains(file)) {
+        m_watcher->addPath(file);
+    }
+}
+
+void Settings::onConfigFileChanged()
+{
+    watchConfigFile();
+    m_reloadTimer->start();
+}
+
+void Settings::reload()
+{
+    // Our own writes come back through here too and change nothing
+    m_settings.sync();
+    const Snapshot next = load();
+    const SnapshotPtr held = snapshot();
+    const Snapshot& current = *held;
+    if (next == current) {
+        return;
+    }
+
+    const bool hotkeyDiffers = next.hotkey != current.hotkey
+        || next.hotkeyModifiers != current.hotkeyModifiers;
+    publish(next);
+
+    Q_EMIT settingsChanged();
+    if (hotkeyDiffers) {
+        Q_EMIT hotkeyChanged();
+    }
+}
@@ -5,7 +5,16 @@
 #include <QSettings>
 #include <QString>
 #include <Qt>
+#include <memory>
 
+class QFileSystemWatcher;
+class QTimer;
+
+// Application settings, persisted with QSettings. Reads are served from an
+// immutable in-memory snapshot that is replaced on every change, so they
+// never touch QSettings or take a lock. Settings belongs to the GUI thread;
+// the typing worker is handed a TypingOptions copy once per paste instead.
+// Edits made to the config file by hand are picked up while running.
 class Settings : public QObject
 {
     Q_OBJECT
@@ -17,8 +26,38 @@ public:
     };
     Q_ENUM(HotkeyMode)
 
+    struct Snapshot
+    {
+        int keyDelayMs = 15;
+        int startDelayMs = 0;
+        bool realtimePacing = false;
+        bool burstEnabled = false;
+        int burstSize = 32;
+        int burstGapMs = 100;
+        bool confirmEnabled = false;
+        int confirmThreshold = 100;
+        QString hotkey = QStringLiteral("V");
+        Qt::KeyboardModifiers hotkeyModifiers = Qt::ControlModifier | Qt::AltModifier;
+        HotkeyMode hotkeyMode = Target;
+        bool historyHotkeysEnabled = false;
+        int historyMemoryKiB = 4096;
+        bool unicodeHexEntry = false;
+        int composeKey = 0;
+        bool coalesceModifiers = false;
+
+        bool operator==(const Snapshot& other) const;
+        bool operator!=(const Snapshot& other) const { return !(*this == other); }
+    };
+
+    // Create the instance on the GUI thread before using it elsewhere
     static Settings* instance();
 
+    using SnapshotPtr = std::shared_ptr<const Snapshot>;
+
+    // GUI thread only. The returned snapshot stays valid while it is held,
+    // a replaced one is freed once its last reader lets go.
+    SnapshotPtr snapshot() const { return m_snapshot; }
+
     // Delay settings
     int keyDelayMs() const;
     void setKeyDelayMs(int ms);
@@ -26,6 +65,19 @@ public:
     int startDelayMs() const;
     void setStartDelayMs(int ms);
 
+    bool realtimePacing() const;
+    void setRealtimePacing(bool enabled);
+
+    // Burst settings
+    bool burstEnabled() const;
+    void setBurstEnabled(bool enabled);
+
+    int burstSize() const;
+    void setBurstSize(int keys);
+
+    int burstGapMs() const;
+    void setBurstGapMs(int ms);
+
     // Confirmation settings
     bool confirmEnabled() const;
     void setConfirmEnabled(bool enabled);
@@ -43,18 +95,55 @@ public:
     HotkeyMode hotkeyMode() const;
     void setHotkeyMode(HotkeyMode mode);
 
+    // Clipboard history settings
+    bool historyHotkeysEnabled() const;
+    void setHistoryHotkeysEnabled(bool enabled);
+
+    int historyMemoryKiB() const;
+    void setHistoryMemoryKiB(int kib);
+
+    // Characters without a key on the layout
+    bool unicodeHexEntry() const;
+    void setUnicodeHexEntry(bool enabled);
+
+    // Evdev key code of the Compose key, 0 for none
+    int composeKey() const;
+    void setComposeKey(int code);
+
+    bool coalesceModifiers() const;
+    void setCoalesceModifiers(bool enabled);
+
     void sync();
 
 Q_SIGNALS:
     void settingsChanged();
     void hotkeyChanged();
 
+private Q_SLOTS:
+    void onConfigFileChanged();
+    void reload();
+
 private:
     explicit Settings(QObject* parent = nullptr);
-    ~Settings() = default;
+    ~Settings();
+
+    Snapshot load();
+    void publish(const Snapshot& next);
+
+    // Stores value under key and publishes a snapshot with it, then emits
+    // changed; does nothing if the value is already current
+    template<typename T>
+    void update(const char* key, T Snapshot::*field, const T& value,
+                void (Settings::*changed)() = &Settings::settingsChanged);
+    void watchConfigFile();
 
     static Settings* s_instance;
     QSettings m_settings;
+
+    SnapshotPtr m_snapshot;
+
+    QFileSystemWatcher* m_watcher;
+    QTimer* m_reloadTimer;
 };
 
 #endif // SETTINGS_H
@@ -8,11 +8,14 @@
 #include <QLabel>
 #include <QSpinBox>
 #include <QCheckBox>
+#include <QComboBox>
 #include <QLineEdit>
 #include <QRadioButton>
 #include <QPushButton>
 #include <QKeyEvent>
 
+#include <linux/input-event-codes.h>
+
 SettingsDialog::SettingsDialog(QWidget* parent)
     : QDialog(parent)
 {
@@ -31,6 +34,8 @@ void SettingsDialog::setupUI()
     mainLayout->addWidget(createConfirmationGroup());
     mainLayout->addWidget(createHotkeyGroup());
     mainLayout->addWidget(createModeGroup());
+    mainLayout->addWidget(createHistoryGroup());
+    mainLayout->addWidget(createCharactersGroup());
 
     // Buttons
     QHBoxLayout* buttonLayout = new QHBoxLayout();
@@ -68,6 +73,33 @@ QGroupBox* SettingsDialog::createDelaysGroup()
     m_keyDelaySpinBox->setSingleStep(5);
     layout->addWidget(m_keyDelaySpinBox, 1, 1);
 
+    m_realtimeCheckBox = new QCheckBox(QStringLiteral("Precise key timing (realtime priority)"));
+    m_realtimeCheckBox->setToolTip(QStringLiteral("Schedules keystrokes with realtime priority so the key delay "
+                                                  "stays steady on a busy system. Needs rtprio permission."));
+    layout->addWidget(m_realtimeCheckBox, 2, 0, 1, 2);
+
+    m_burstCheckBox = new QCheckBox(QStringLiteral("Burst mode (for buffered KVMs and consoles)"));
+    m_burstCheckBox->setToolTip(QStringLiteral("Type several keys at full speed, then pause so the target "
+                                               "can drain its buffer. Replaces the key delay."));
+    layout->addWidget(m_burstCheckBox, 3, 0, 1, 2);
+
+    layout->addWidget(new QLabel(QStringLiteral("Keys per burst:")), 4, 0);
+    m_burstSizeSpinBox = new QSpinBox();
+    m_burstSizeSpinBox->setRange(1, 1000);
+    layout->addWidget(m_burstSizeSpinBox, 4, 1);
+
+    layout->addWidget(new QLabel(QStringLiteral("Burst gap (ms):")), 5, 0);
+    m_burstGapSpinBox = new QSpinBox();
+    m_burstGapSpinBox->setRange(0, 10000);
+    m_burstGapSpinBox->setSingleStep(10);
+    layout->addWidget(m_burstGapSpinBox, 5, 1);
+
+    connect(m_burstCheckBox, &QCheckBox::toggled, this, [this](bool burst) {
+        m_burstSizeSpinBox->setEnabled(burst);
+        m_burstGapSpinBox->setEnabled(burst);
+        m_keyDelaySpinBox->setEnabled(!burst);
+    });
+
     layout->setColumnStretch(1, 1);
     return group;
 }
@@ -140,12 +172,70 @@ QGroupBox* SettingsDialog::createModeGroup()
     return group;
 }
 
+QGroupBox* SettingsDialog::createHistoryGroup()
+{
+    QGroupBox* group = new QGroupBox(QStringLiteral("Clipboard History"));
+    QGridLayout* layout = new QGridLayout(group);
+
+    m_historyHotkeysCheckBox = new QCheckBox(QStringLiteral("Type history entries with modifiers + 1..9"));
+    m_historyHotkeysCheckBox->setToolTip(QStringLiteral("Uses the hotkey modifiers with a digit: 1 is the current "
+                                                        "clipboard, 2 the one before, and so on."));
+    layout->addWidget(m_historyHotkeysCheckBox, 0, 0, 1, 2);
+
+    layout->addWidget(new QLabel(QStringLiteral("Memory limit:")), 1, 0);
+    m_historyMemorySpinBox = new QSpinBox();
+    m_historyMemorySpinBox->setRange(64, 1024 * 1024);
+    m_historyMemorySpinBox->setSingleStep(1024);
+    m_historyMemorySpinBox->setSuffix(QStringLiteral(" KiB"));
+    layout->addWidget(m_historyMemorySpinBox, 1, 1);
+
+    layout->setColumnStretch(1, 1);
+    return group;
+}
+
+QGroupBox* SettingsDialog::createCharactersGroup()
+{
+    QGroupBox* group = new QGroupBox(QStringLiteral("Special Characters"));
+    QGridLayout* layout = new QGridLayout(group);
+
+    m_hexEntryCheckBox = new QCheckBox(QStringLiteral("Type other characters with Ctrl+Shift+U"));
+    m_hexEntryCheckBox->setToolTip(QStringLiteral("Enters characters that have no key, such as box drawing, "
+                                                  "as Unicode hex codes. Needs IBus or Fcitx in the target."));
+    layout->addWidget(m_hexEntryCheckBox, 0, 0, 1, 2);
+
+    layout->addWidget(new QLabel(QStringLiteral("Compose Key:")), 1, 0);
+    m_composeKeyComboBox = new QComboBox();
+    m_composeKeyComboBox->addItem(QStringLiteral("None"), 0);
+    m_composeKeyComboBox->addItem(QStringLiteral("Right Alt"), KEY_RIGHTALT);
+    m_composeKeyComboBox->addItem(QStringLiteral("Menu"), KEY_COMPOSE);
+    m_composeKeyComboBox->addItem(QStringLiteral("Caps Lock"), KEY_CAPSLOCK);
+    m_composeKeyComboBox->addItem(QStringLiteral("Scroll Lock"), KEY_SCROLLLOCK);
+    m_composeKeyComboBox->setToolTip(QStringLiteral("The key your keyboard layout uses as Compose. Accented "
+                                                    "letters, dashes and quotes are typed with it."));
+    layout->addWidget(m_composeKeyComboBox, 1, 1);
+
+    m_coalesceCheckBox = new QCheckBox(QStringLiteral("Hold Shift across runs of capitals"));
+    m_coalesceCheckBox->setToolTip(QStringLiteral("Presses Shift once for a run like HELLO instead of once per "
+                                                  "letter. Fewer key events for uppercase text, tokens and hex."));
+    layout->addWidget(m_coalesceCheckBox, 2, 0, 1, 2);
+
+    layout->setColumnStretch(1, 1);
+    return group;
+}
+
 void SettingsDialog::loadSettings()
 {
     Settings* s = Settings::instance();
 
     m_startDelaySpinBox->setValue(s->startDelayMs());
     m_keyDelaySpinBox->setValue(s->keyDelayMs());
+    m_realtimeCheckBox->setChecked(s->realtimePacing());
+    m_burstCheckBox->setChecked(s->burstEnabled());
+    m_burstSizeSpinBox->setValue(s->burstSize());
+    m_burstGapSpinBox->setValue(s->burstGapMs());
+    m_burstSizeSpinBox->setEnabled(s->burstEnabled());
+    m_burstGapSpinBox->setEnabled(s->burstEnabled());
+    m_keyDelaySpinBox->setEnabled(!s->burstEnabled());
 
     m_confirmCheckBox->setChecked(s->confirmEnabled());
     m_confirmThresholdSpinBox->setValue(s->confirmThreshold());
@@ -164,6 +254,13 @@ void SettingsDialog::loadSettings()
     } else {
         m_targetModeRadio->setChecked(true);
     }
+
+    m_historyHotkeysCheckBox->setChecked(s->historyHotkeysEnabled());
+    m_historyMemorySpinBox->setValue(s->historyMemoryKiB());
+
+    m_hexEntryCheckBox->setChecked(s->unicodeHexEntry());
+    m_composeKeyComboBox->setCurrentIndex(qMax(0, m_composeKeyComboBox->findData(s->composeKey())));
+    m_coalesceCheckBox->setChecked(s->coalesceModifiers());
 }
 
 void SettingsDialog::saveSettings()
@@ -172,6 +269,10 @@ void SettingsDialog::saveSettings()
 
     s->setStartDelayMs(m_startDelaySpinBox->value());
     s->setKeyDelayMs(m_keyDelaySpinBox->value());
+    s->setRealtimePacing(m_realtimeCheckBox->isChecked());
+    s->setBurstEnabled(m_burstCheckBox->isChecked());
+    s->setBurstSize(m_burstSizeSpinBox->value());
+    s->setBurstGapMs(m_burstGapSpinBox->value());
 
     s->setConfirmEnabled(m_confirmCheckBox->isChecked());
     s->setConfirmThreshold(m_confirmThresholdSpinBox->value());
@@ -191,6 +292,13 @@ void SettingsDialog::saveSettings()
 
     s->setHotkeyMode(m_justGoModeRadio->isChecked() ? Settings::JustGo : Settings::Target);
 
+    s->setHistoryHotkeysEnabled(m_historyHotkeysCheckBox->isChecked());
+    s->setHistoryMemoryKiB(m_historyMemorySpinBox->value());
+
+    s->setUnicodeHexEntry(m_hexEntryCheckBox->isChecked());
+    s->setComposeKey(m_composeKeyComboBox->currentData().toInt());
+    s->setCoalesceModifiers(m_coalesceCheckBox->isChecked());
+
     s->sync();
 }
 
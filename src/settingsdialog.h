@@ -5,6 +5,7 @@
 
 class QSpinBox;
 class QCheckBox;
+class QComboBox;
 class QLineEdit;
 class QRadioButton;
 class QGroupBox;
@@ -28,10 +29,16 @@ private:
     QGroupBox* createConfirmationGroup();
     QGroupBox* createHotkeyGroup();
     QGroupBox* createModeGroup();
+    QGroupBox* createHistoryGroup();
+    QGroupBox* createCharactersGroup();
 
     // Delay controls
     QSpinBox* m_startDelaySpinBox;
     QSpinBox* m_keyDelaySpinBox;
+    QCheckBox* m_realtimeCheckBox;
+    QCheckBox* m_burstCheckBox;
+    QSpinBox* m_burstSizeSpinBox;
+    QSpinBox* m_burstGapSpinBox;
 
     // Confirmation controls
     QCheckBox* m_confirmCheckBox;
@@ -47,6 +54,15 @@ private:
     // Mode controls
     QRadioButton* m_targetModeRadio;
     QRadioButton* m_justGoModeRadio;
+
+    // History controls
+    QCheckBox* m_historyHotkeysCheckBox;
+    QSpinBox* m_historyMemorySpinBox;
+
+    // Special character controls
+    QCheckBox* m_hexEntryCheckBox;
+    QComboBox* m_composeKeyComboBox;
+    QCheckBox* m_coalesceCheckBox;
 };
 
 #endif // SETTINGSDIALOG_H
@@ -6,23 +6,28 @@
 #include <QMouseEvent>
 #include <QKeyEvent>
 #include <QCursor>
+#include <QTimer>
 #include <QWindow>
 
 #include <LayerShellQt/Window>
 
+namespace {
+// Hidden overlays are destroyed after this long without targeting
+constexpr int IdleTimeoutMs = 60000;
+}
+
 // ============================================================================
 // TargetOverlay - manages overlays across all screens
 // ============================================================================
 
 TargetOverlay::TargetOverlay(QObject* parent)
     : QObject(parent)
+    , m_idleTimer(new QTimer(this))
     , m_active(false)
 {
-    // Create overlays for existing screens
-    const auto screens = QGuiApplication::screens();
-    for (QScreen* screen : screens) {
-        createOverlayForScreen(screen);
-    }
+    m_idleTimer->setSingleShot(true);
+    m_idleTimer->setInterval(IdleTimeoutMs);
+    connect(m_idleTimer, &QTimer::timeout, this, &TargetOverlay::releaseOverlays);
 
     // Handle dynamic screen changes
     connect(qApp, &QGuiApplication::screenAdded, this, &TargetOverlay::onScreenAdded);
@@ -42,6 +47,15 @@ void TargetOverlay::activate()
     }
 
     m_active = true;
+    m_idleTimer->stop();
+
+    // Reuse the overlays from the last activation, create missing ones
+    const auto screens = QGuiApplication::screens();
+    for (QScreen* screen : screens) {
+        if (!overlayForScreen(screen)) {
+            createOverlayForScreen(screen);
+        }
+    }
 
     for (ScreenOverlay* overlay : m_overlays) {
         overlay->activate();
@@ -59,6 +73,8 @@ void TargetOverlay::deactivate()
     for (ScreenOverlay* overlay : m_overlays) {
         overlay->deactivate();
     }
+
+    m_idleTimer->start();
 }
 
 bool TargetOverlay::isActive() const
@@ -66,10 +82,32 @@ bool TargetOverlay::isActive() const
     return m_active;
 }
 
+void TargetOverlay::setIdleTimeout(int msec)
+{
+    m_idleTimer->setInterval(msec);
+}
+
+int TargetOverlay::overlayCount() const
+{
+    return m_overlays.size();
+}
+
+void TargetOverlay::releaseOverlays()
+{
+    if (m_active) {
+        return;
+    }
+
+    // Frees the windows and their backing stores until the next activation
+    qDeleteAll(m_overlays);
+    m_overlays.clear();
+}
+
 void TargetOverlay::onScreenAdded(QScreen* screen)
 {
-    createOverlayForScreen(screen);
+    // Otherwise created on the next activate()
     if (m_active) {
+        createOverlayForScreen(screen);
         m_overlays.last()->activate();
     }
 }
@@ -99,6 +137,16 @@ void TargetOverlay::createOverlayForScreen(QScreen* screen)
     m_overlays.append(overlay);
 }
 
+ScreenOverlay* TargetOverlay::overlayForScreen(QScreen* screen) const
+{
+    for (ScreenOverlay* overlay : m_overlays) {
+        if (overlay->screen() == screen) {
+            return overlay;
+        }
+    }
+    return nullptr;
+}
+
 void TargetOverlay::removeOverlayForScreen(QScreen* screen)
 {
     for (int i = 0; i < m_overlays.size(); ++i) {
@@ -120,7 +168,8 @@ ScreenOverlay::ScreenOverlay(QScreen* screen, QWidget* parent)
 {
     setAttribute(Qt::WA_TranslucentBackground);
     setAttribute(Qt::WA_ShowWithoutActivating);
-    setMouseTracking(true);
+    // The compositor draws the crosshair cursor; nothing we paint follows
+    // the mouse, so moves are not tracked and never cause a repaint
     setCursor(Qt::CrossCursor);
 
     // Set geometry to match screen
@@ -186,33 +235,47 @@ void ScreenOverlay::hideEvent(QHideEvent* event)
 
 void ScreenOverlay::paintEvent(QPaintEvent* event)
 {
-    Q_UNUSED(event)
-
     QPainter painter(this);
 
-    // Very subtle semi-transparent overlay - just enough to show targeting is active
-    painter.fillRect(rect(), QColor(0, 0, 0, 15));
+    // Very subtle semi-transparent overlay - just enough to show targeting is active.
+    // Only the exposed parts are filled.
+    for (const QRect& rect : event->region()) {
+        painter.fillRect(rect, QColor(0, 0, 0, 15));
+    }
 
     // Instruction text at top
-    painter.setPen(Qt::white);
-    QFont font = painter.font();
-    font.setPointSize(12);
-    font.setBold(true);
-    painter.setFont(font);
-
-    QString text = QStringLiteral("Click target window (ESC to cancel)");
-    QRect textRect = painter.fontMetrics().boundingRect(text);
-    textRect.moveCenter(QPoint(width() / 2, 30));
-
-    QRect bgRect = textRect.adjusted(-10, -5, 10, 5);
-    painter.fillRect(bgRect, QColor(0, 0, 0, 180));
-    painter.drawText(textRect, Qt::AlignCenter, text);
+    updateBanner();
+    QRect bannerRect(QPoint(0, 0), m_banner.deviceIndependentSize().toSize());
+    bannerRect.moveCenter(QPoint(width() / 2, 30));
+    if (event->region().intersects(bannerRect)) {
+        painter.drawPixmap(bannerRect.topLeft(), m_banner);
+    }
 }
 
-void ScreenOverlay::mousePressEvent(QMouseEvent* event)
+void ScreenOverlay::updateBanner()
 {
-    m_cursorPos = event->pos();
-    update();
+    // Rendered once per device pixel ratio instead of laid out on every paint
+    const qreal ratio = devicePixelRatioF();
+    if (!m_banner.isNull() && qFuzzyCompare(m_banner.devicePixelRatio(), ratio)) {
+        return;
+    }
+
+    QFont bannerFont = font();
+    bannerFont.setPointSize(12);
+    bannerFont.setBold(true);
+
+    const QString text = QStringLiteral("Click target window (ESC to cancel)");
+    const QRect textRect = QFontMetrics(bannerFont).boundingRect(text);
+    const QRect bgRect = textRect.adjusted(-10, -5, 10, 5);
+
+    m_banner = QPixmap(bgRect.size() * ratio);
+    m_banner.setDevicePixelRatio(ratio);
+    m_banner.fill(QColor(0, 0, 0, 180));
+
+    QPainter painter(&m_banner);
+    painter.setPen(Qt::white);
+    painter.setFont(bannerFont);
+    painter.drawText(QRect(QPoint(10, 5), textRect.size()), Qt::AlignCenter, text);
 }
 
 void ScreenOverlay::mouseReleaseEvent(QMouseEvent* event)
@@ -222,26 +285,6 @@ void ScreenOverlay::mouseReleaseEvent(QMouseEvent* event)
     }
 }
 
-void ScreenOverlay::mouseMoveEvent(QMouseEvent* event)
-{
-    m_cursorPos = event->pos();
-    update();
-}
-
-void ScreenOverlay::enterEvent(QEnterEvent* event)
-{
-    Q_UNUSED(event)
-    // Cursor entered this screen - will be updated by mouseMoveEvent
-}
-
-void ScreenOverlay::leaveEvent(QEvent* event)
-{
-    Q_UNUSED(event)
-    // Clear crosshair when cursor leaves this screen
-    m_cursorPos = QPoint();
-    update();
-}
-
 void ScreenOverlay::keyPressEvent(QKeyEvent* event)
 {
     if (event->key() == Qt::Key_Escape) {
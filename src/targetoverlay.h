@@ -2,6 +2,7 @@
 #define TARGETOVERLAY_H
 
 #include <QWidget>
+#include <QPixmap>
 #include <QPoint>
 #include <QList>
 
@@ -10,8 +11,12 @@ class Window;
 }
 
 class QScreen;
+class QTimer;
 class ScreenOverlay;
 
+// Full-screen click targets on every screen. The per-screen windows exist
+// only while targeting is in use: they are created on activate(), kept
+// for quick re-use, and destroyed after a period without targeting.
 class TargetOverlay : public QObject
 {
     Q_OBJECT
@@ -24,6 +29,10 @@ public:
     void deactivate();
     bool isActive() const;
 
+    // How long hidden overlays are kept before they are destroyed
+    void setIdleTimeout(int msec);
+    int overlayCount() const;
+
 Q_SIGNALS:
     void targetSelected(const QPoint& globalPos);
     void cancelled();
@@ -33,12 +42,16 @@ private Q_SLOTS:
     void onScreenRemoved(QScreen* screen);
     void onOverlayClicked(const QPoint& globalPos);
     void onOverlayCancelled();
+    void releaseOverlays();
 
 private:
     void createOverlayForScreen(QScreen* screen);
     void removeOverlayForScreen(QScreen* screen);
 
+    ScreenOverlay* overlayForScreen(QScreen* screen) const;
+
     QList<ScreenOverlay*> m_overlays;
+    QTimer* m_idleTimer;
     bool m_active;
 };
 
@@ -63,19 +76,16 @@ protected:
     void showEvent(QShowEvent* event) override;
     void hideEvent(QHideEvent* event) override;
     void paintEvent(QPaintEvent* event) override;
-    void mousePressEvent(QMouseEvent* event) override;
     void mouseReleaseEvent(QMouseEvent* event) override;
-    void mouseMoveEvent(QMouseEvent* event) override;
-    void enterEvent(QEnterEvent* event) override;
-    void leaveEvent(QEvent* event) override;
     void keyPressEvent(QKeyEvent* event) override;
 
 private:
     void setupLayerShell();
+    void updateBanner();
 
     QScreen* m_screen;
     LayerShellQt::Window* m_layerWindow;
-    QPoint m_cursorPos;
+    QPixmap m_banner;
 };
 
 #endif // TARGETOVERLAY_H
@@ -0,0 +1,248 @@
+#include "textnormalizer.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CLICKPASTE_X86_SIMD 1
+#endif
+
+namespace {
+
+// Totals for a run of bytes that contains no \r
+struct RunCounts
+{
+    qsizetype lineFeeds = 0;
+    qsizetype continuations = 0;
+    bool nonAscii = false;
+};
+
+// Returns the length of the longest prefix, in whole blocks, without a \r
+using ScanFunction = qsizetype (*)(const char* data, qsizetype size, RunCounts& counts);
+
+#ifdef CLICKPASTE_X86_SIMD
+__attribute__((target("sse2")))
+qsizetype scanSse2(const char* data, qsizetype size, RunCounts& counts)
+{
+    const __m128i cr = _mm_set1_epi8('\r');
+    const __m128i lf = _mm_set1_epi8('\n');
+    const __m128i firstLead = _mm_set1_epi8(static_cast<char>(0xC0));
+
+    qsizetype i = 0;
+    int high = 0;
+    for (; i + 16 <= size; i += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(v, cr))) {
+            break;
+        }
+        counts.lineFeeds += __builtin_popcount(_mm_movemask_epi8(_mm_cmpeq_epi8(v, lf)));
+        // Continuation bytes 0x80..0xBF are the signed bytes below 0xC0
+        counts.continuations += __builtin_popcount(_mm_movemask_epi8(_mm_cmplt_epi8(v, firstLead)));
+        high |= _mm_movemask_epi8(v);
+    }
+    counts.nonAscii |= high != 0;
+    return i;
+}
+
+__attribute__((target("avx2")))
+qsizetype scanAvx2(const char* data, qsizetype size, RunCounts& counts)
+{
+    const __m256i cr = _mm256_set1_epi8('\r');
+    const __m256i lf = _mm256_set1_epi8('\n');
+    const __m256i firstLead = _mm256_set1_epi8(static_cast<char>(0xC0));
+
+    qsizetype i = 0;
+    unsigned high = 0;
+    for (; i + 32 <= size; i += 32) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, cr))) {
+            break;
+        }
+        counts.lineFeeds += __builtin_popcount(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, lf)));
+        counts.continuations += __builtin_popcount(_mm256_movemask_epi8(_mm256_cmpgt_epi8(firstLead, v)));
+        high |= _mm256_movemask_epi8(v);
+    }
+    counts.nonAscii |= high != 0;
+    return i;
+}
+#endif
+
+ScanFunction selectScanFunction()
+{
+#ifdef CLICKPASTE_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return scanAvx2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return scanSse2;
+    }
+#endif
+    return nullptr;
+}
+
+// Null without vector support; normalizeScalar() then does all the work
+const ScanFunction scanRun = selectScanFunction();
+
+// Bytes handled by the scalar path after the vector scan hits a \r
+constexpr qsizetype ScalarStep = 64;
+
+} // namespace
+
+TextNormalizer::TextNormalizer()
+{
+    reset();
+}
+
+void TextNormalizer::reset()
+{
+    m_stats = Stats();
+    m_pendingCR = false;
+    m_need = 0;
+    m_low = 0x80;
+    m_high = 0xBF;
+}
+
+void TextNormalizer::feed(QByteArrayView data, QByteArray& out)
+{
+    if (data.isEmpty()) {
+        return;
+    }
+
+    // Normalizing never makes the text longer
+    const qsizetype start = out.size();
+    out.resize(start + data.size());
+    char* dst = out.data() + start;
+
+    const char* p = data.data();
+    const char* const end = p + data.size();
+    while (p < end) {
+        if (!m_pendingCR && scanRun) {
+            RunCounts counts;
+            const qsizetype run = scanRun(p, end - p, counts);
+            if (run > 0) {
+                std::memcpy(dst, p, run);
+                // Second pass, only over runs that are not plain ASCII
+                if (counts.nonAscii || m_need > 0) {
+                    validate(p, p + run);
+                }
+                m_stats.characters += run - counts.continuations;
+                m_stats.lines += counts.lineFeeds;
+                p += run;
+                dst += run;
+                continue;
+            }
+        }
+
+        const char* stop = scanRun && end - p > ScalarStep ? p + ScalarStep : end;
+        dst = normalizeScalar(p, stop, dst);
+        p = stop;
+    }
+
+    out.truncate(dst - out.constData());
+}
+
+void TextNormalizer::finish()
+{
+    if (m_need > 0) {
+        m_stats.valid = false;
+        m_need = 0;
+    }
+    m_pendingCR = false;
+}
+
+QByteArray TextNormalizer::normalized(QByteArrayView data, Stats* stats)
+{
+    TextNormalizer normalizer;
+    QByteArray out;
+    normalizer.feed(data, out);
+    normalizer.finish();
+    if (stats) {
+        *stats = normalizer.stats();
+    }
+    return out;
+}
+
+char* TextNormalizer::normalizeScalar(const char* p, const char* end, char* out)
+{
+    for (; p < end; ++p) {
+        const uchar byte = static_cast<uchar>(*p);
+
+        if (m_pendingCR) {
+            m_pendingCR = false;
+            if (byte == '\n') {
+                continue; // the \r already produced this line break
+            }
+        }
+
+        if (byte == '\r') {
+            m_pendingCR = true;
+            *out++ = '\n';
+            ++m_stats.lines;
+            ++m_stats.characters;
+            validateByte(byte);
+            continue;
+        }
+
+        *out++ = static_cast<char>(byte);
+        if (byte == '\n') {
+            ++m_stats.lines;
+        }
+        if ((byte & 0xC0) != 0x80) {
+            ++m_stats.characters;
+        }
+        validateByte(byte);
+    }
+    return out;
+}
+
+void TextNormalizer::validate(const char* p, const char* end)
+{
+    for (; p < end; ++p) {
+        validateByte(static_cast<uchar>(*p));
+    }
+}
+
+void TextNormalizer::validateByte(uchar byte)
+{
+    if (m_need > 0) {
+        if (byte >= m_low && byte <= m_high) {
+            --m_need;
+            m_low = 0x80;
+            m_high = 0xBF;
+            return;
+        }
+        // Truncated sequence; look at this byte as a new lead byte
+        m_stats.valid = false;
+        m_need = 0;
+        m_low = 0x80;
+        m_high = 0xBF;
+    }
+
+    if (byte < 0x80) {
+        return;
+    }
+
+    // Second byte ranges exclude overlong forms, surrogates and > U+10FFFF
+    if (byte >= 0xC2 && byte <= 0xDF) {
+        m_need = 1;
+    } else if (byte == 0xE0) {
+        m_need = 2;
+        m_low = 0xA0;
+    } else if (byte == 0xED) {
+        m_need = 2;
+        m_high = 0x9F;
+    } else if (byte >= 0xE1 && byte <= 0xEF) {
+        m_need = 2;
+    } else if (byte == 0xF0) {
+        m_need = 3;
+        m_low = 0x90;
+    } else if (byte >= 0xF1 && byte <= 0xF3) {
+        m_need = 3;
+    } else if (byte == 0xF4) {
+        m_need = 3;
+        m_high = 0x8F;
+    } else {
+        m_stats.valid = false;
+    }
+}
@@ -0,0 +1,52 @@
+#ifndef TEXTNORMALIZER_H
+#define TEXTNORMALIZER_H
+
+#include <QByteArray>
+#include <QByteArrayView>
+
+// Normalizes line endings (\r\n and lone \r become \n) in UTF-8 text while
+// validating it and counting characters and lines. Long runs without \r are
+// scanned with SSE2/AVX2 where available; that scan counts and copies but
+// does not validate, so a run containing non-ASCII bytes is read a second
+// time by the scalar validator. Pure ASCII takes a single pass. Stateful,
+// so input may be fed in arbitrary chunks.
+class TextNormalizer
+{
+public:
+    struct Stats
+    {
+        qsizetype characters = 0;
+        qsizetype lines = 0;
+        bool valid = true;
+    };
+
+    TextNormalizer();
+
+    void reset();
+
+    // Appends the normalized form of data to out
+    void feed(QByteArrayView data, QByteArray& out);
+
+    // Call after the last feed(); flags a truncated trailing sequence
+    void finish();
+
+    const Stats& stats() const { return m_stats; }
+
+    static QByteArray normalized(QByteArrayView data, Stats* stats = nullptr);
+
+private:
+    char* normalizeScalar(const char* p, const char* end, char* out);
+    void validate(const char* p, const char* end);
+    void validateByte(uchar byte);
+
+    Stats m_stats;
+    bool m_pendingCR;
+
+    // UTF-8 validation state: continuation bytes still expected and the
+    // allowed range for the next one
+    int m_need;
+    uchar m_low;
+    uchar m_high;
+};
+
+#endif // TEXTNORMALIZER_H
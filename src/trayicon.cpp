@@ -12,14 +12,19 @@ TrayIcon::TrayIcon(QObject* parent)
     : QObject(parent)
     , m_trayIcon(new QSystemTrayIcon(this))
     , m_contextMenu(nullptr)
+    , m_pauseAction(nullptr)
+    , m_cancelAction(nullptr)
+    , m_continueAction(nullptr)
+    , m_typeFileAction(nullptr)
     , m_settingsAction(nullptr)
+    , m_statisticsAction(nullptr)
     , m_exitAction(nullptr)
     , m_iconState(Normal)
 {
     createContextMenu();
     updateIcon();
 
-    m_trayIcon->setToolTip(QStringLiteral("ClickPaste: Click to choose a target"));
+    updateToolTip();
 
     connect(m_trayIcon, &QSystemTrayIcon::activated,
             this, &TrayIcon::onActivated);
@@ -45,9 +50,24 @@ void TrayIcon::setIconState(IconState state)
     if (m_iconState != state) {
         m_iconState = state;
         updateIcon();
+        updateToolTip();
+        updateActions();
     }
 }
 
+void TrayIcon::setProgress(int current, int total)
+{
+    const int percent = total > 0 ? static_cast<int>(qint64(current) * 100 / total) : 0;
+    m_trayIcon->setToolTip(QStringLiteral("ClickPaste: Typing %1 of %2 characters (%3%)")
+                               .arg(current).arg(total).arg(percent));
+}
+
+void TrayIcon::setContinueAvailable(int remaining)
+{
+    m_continueAction->setText(QStringLiteral("Continue Cancelled Paste (%1 characters left)").arg(remaining));
+    m_continueAction->setVisible(remaining > 0);
+}
+
 void TrayIcon::showMessage(const QString& title, const QString& message,
                            QSystemTrayIcon::MessageIcon icon)
 {
@@ -65,15 +85,42 @@ void TrayIcon::createContextMenu()
 {
     m_contextMenu = new QMenu();
 
+    m_pauseAction = m_contextMenu->addAction(QStringLiteral("Pause Typing"));
+    connect(m_pauseAction, &QAction::triggered, this, [this]() {
+        if (m_iconState == Paused) {
+            Q_EMIT resumeRequested();
+        } else {
+            Q_EMIT pauseRequested();
+        }
+    });
+
+    m_cancelAction = m_contextMenu->addAction(QStringLiteral("Cancel Typing"));
+    connect(m_cancelAction, &QAction::triggered, this, &TrayIcon::cancelRequested);
+
+    m_continueAction = m_contextMenu->addAction(QStringLiteral("Continue Cancelled Paste"));
+    m_continueAction->setVisible(false);
+    connect(m_continueAction, &QAction::triggered, this, &TrayIcon::continueRequested);
+
+    m_contextMenu->addSeparator();
+
+    m_typeFileAction = m_contextMenu->addAction(QStringLiteral("Type File..."));
+    connect(m_typeFileAction, &QAction::triggered, this, &TrayIcon::typeFileRequested);
+
+    m_contextMenu->addSeparator();
+
     m_settingsAction = m_contextMenu->addAction(QStringLiteral("Settings..."));
     connect(m_settingsAction, &QAction::triggered, this, &TrayIcon::settingsRequested);
 
+    m_statisticsAction = m_contextMenu->addAction(QStringLiteral("Statistics..."));
+    connect(m_statisticsAction, &QAction::triggered, this, &TrayIcon::statisticsRequested);
+
     m_contextMenu->addSeparator();
 
     m_exitAction = m_contextMenu->addAction(QStringLiteral("Exit"));
     connect(m_exitAction, &QAction::triggered, this, &TrayIcon::exitRequested);
 
     m_trayIcon->setContextMenu(m_contextMenu);
+    updateActions();
 }
 
 void TrayIcon::updateIcon()
@@ -84,6 +131,7 @@ void TrayIcon::updateIcon()
     switch (m_iconState) {
     case Normal:
     case Targeting:
+    case Paused:
         // Use light icon on dark themes, dark icon on light themes
         iconName = dark ? QStringLiteral(":/icons/clickpaste-dark.svg")
                         : QStringLiteral(":/icons/clickpaste.svg");
@@ -102,6 +150,27 @@ void TrayIcon::updateIcon()
     }
 }
 
+void TrayIcon::updateToolTip()
+{
+    if (m_iconState == Typing) {
+        m_trayIcon->setToolTip(QStringLiteral("ClickPaste: Typing..."));
+    } else if (m_iconState == Paused) {
+        m_trayIcon->setToolTip(QStringLiteral("ClickPaste: Paused"));
+    } else {
+        m_trayIcon->setToolTip(QStringLiteral("ClickPaste: Click to choose a target"));
+    }
+}
+
+void TrayIcon::updateActions()
+{
+    const bool busy = m_iconState == Typing || m_iconState == Paused;
+    m_pauseAction->setVisible(busy);
+    m_pauseAction->setText(m_iconState == Paused ? QStringLiteral("Resume Typing")
+                                                 : QStringLiteral("Pause Typing"));
+    m_cancelAction->setVisible(busy);
+    m_typeFileAction->setEnabled(!busy);
+}
+
 bool TrayIcon::isDarkTheme() const
 {
     // Check the window background color luminance
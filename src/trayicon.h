@@ -15,7 +15,8 @@ public:
     enum IconState {
         Normal,
         Typing,
-        Targeting
+        Targeting,
+        Paused
     };
 
     explicit TrayIcon(QObject* parent = nullptr);
@@ -25,12 +26,21 @@ public:
     void hide();
 
     void setIconState(IconState state);
+    void setProgress(int current, int total);
+    // Offers to continue a cancelled paste; 0 hides the action
+    void setContinueAvailable(int remaining);
     void showMessage(const QString& title, const QString& message,
                      QSystemTrayIcon::MessageIcon icon = QSystemTrayIcon::Information);
 
 Q_SIGNALS:
     void activated();
     void settingsRequested();
+    void statisticsRequested();
+    void pauseRequested();
+    void resumeRequested();
+    void cancelRequested();
+    void continueRequested();
+    void typeFileRequested();
     void exitRequested();
 
 private Q_SLOTS:
@@ -39,11 +49,18 @@ private Q_SLOTS:
 private:
     void createContextMenu();
     void updateIcon();
+    void updateToolTip();
+    void updateActions();
     bool isDarkTheme() const;
 
     QSystemTrayIcon* m_trayIcon;
     QMenu* m_contextMenu;
+    QAction* m_pauseAction;
+    QAction* m_cancelAction;
+    QAction* m_continueAction;
+    QAction* m_typeFileAction;
     QAction* m_settingsAction;
+    QAction* m_statisticsAction;
     QAction* m_exitAction;
     IconState m_iconState;
 };
@@ -0,0 +1,17 @@
+#include "typingoptions.h"
+
+TypingOptions typingOptions(const Settings::Snapshot& s)
+{
+    TypingOptions options;
+    options.keyDelayMs = s.keyDelayMs;
+    options.startDelayMs = s.startDelayMs;
+    options.realtimePacing = s.realtimePacing;
+    if (s.burstEnabled) {
+        options.burstSize = s.burstSize;
+        options.burstGapMs = s.burstGapMs;
+    }
+    options.unicodeHexEntry = s.unicodeHexEntry;
+    options.composeKey = s.composeKey;
+    options.coalesceModifiers = s.coalesceModifiers;
+    return options;
+}
@@ -0,0 +1,31 @@
+#ifndef TYPINGOPTIONS_H
+#define TYPINGOPTIONS_H
+
+#include "settings.h"
+
+// Parameters for one paste, captured from Settings on the GUI thread so
+// the typing worker never has to read settings itself
+struct TypingOptions
+{
+    int keyDelayMs = 15;
+    int startDelayMs = 0;
+    bool realtimePacing = false;
+
+    // Burst mode: burstSize keys at full speed, then burstGapMs. Replaces
+    // the key delay when burstSize > 0.
+    int burstSize = 0;
+    int burstGapMs = 0;
+
+    // Fallbacks for characters without a key on the layout; composeKey is
+    // the evdev code of the Compose key, 0 for none
+    bool unicodeHexEntry = false;
+    int composeKey = 0;
+
+    // Hold Shift across runs of capitals rather than per character
+    bool coalesceModifiers = false;
+};
+
+// The options a paste started with these settings uses
+TypingOptions typingOptions(const Settings::Snapshot& s);
+
+#endif // TYPINGOPTIONS_H
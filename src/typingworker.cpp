@@ -0,0 +1,658 @@
+#include "typingworker.h"
+#include "eventencoder.h"
+#include "filereader.h"
+#include "pacer.h"
+#include "textnormalizer.h"
+#include "uinputbackend.h"
+#include "ydotoolclibackend.h"
+#include "ydotoolsocketbackend.h"
+
+#include <QDebug>
+#include <QProcess>
+#include <QStandardPaths>
+#include <QFile>
+#include <QFileInfo>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace {
+// Bytes handed to the backend per chunk; also the progress granularity
+constexpr int ChunkSize = 64;
+
+constexpr qint64 NsPerMs = 1000000;
+
+// Bytes of a file that are read and normalized at a time
+constexpr qsizetype FileWindowSize = 1024 * 1024;
+
+// How long a freshly started ydotoold gets to create its socket
+constexpr int SocketTimeoutMs = 3000;
+
+// Blocks until path exists, using inotify on its directory
+bool waitForFile(const QString& path, int timeoutMs)
+{
+    const QFileInfo info(path);
+    const int fd = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+    if (fd < 0 || inotify_add_watch(fd, QFile::encodeName(info.absolutePath()).constData(),
+                                    IN_CREATE | IN_MOVED_TO) < 0) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        qWarning() << "inotify unavailable:" << strerror(errno);
+        return QFile::exists(path);
+    }
+
+    // Checked after adding the watch so a creation in between is not missed
+    const qint64 deadline = Pacer::now() + timeoutMs * NsPerMs;
+    bool found = QFile::exists(path);
+    while (!found) {
+        const qint64 remainingMs = (deadline - Pacer::now()) / NsPerMs;
+        if (remainingMs <= 0) {
+            break;
+        }
+
+        pollfd pfd = {fd, POLLIN, 0};
+        if (poll(&pfd, 1, static_cast<int>(remainingMs)) < 0 && errno != EINTR) {
+            break;
+        }
+
+        // Drain the events, then look at the file itself
+        alignas(inotify_event) char events[4096];
+        while (read(fd, events, sizeof(events)) > 0) {
+        }
+        found = QFile::exists(path);
+    }
+
+    close(fd);
+    return found;
+}
+
+bool isContinuationByte(char byte)
+{
+    return (static_cast<uchar>(byte) & 0xC0) == 0x80;
+}
+
+// Moves a slice end that falls inside a UTF-8 sequence past the rest of
+// it. Never more than three bytes, so a run of stray continuation bytes
+// cannot make a slice larger than what was reserved for it.
+qsizetype sequenceEnd(QByteArrayView text, qsizetype end)
+{
+    for (int i = 0; i < 3 && end < text.size() && isContinuationByte(text.at(end)); ++i) {
+        ++end;
+    }
+    return end;
+}
+
+// Length of text without a UTF-8 sequence cut off at its end
+qsizetype completeLength(QByteArrayView text)
+{
+    qsizetype lead = text.size();
+    while (lead > 0 && text.size() - lead < 4 && isContinuationByte(text[lead - 1])) {
+        --lead;
+    }
+    if (lead == 0) {
+        return text.size();
+    }
+
+    const uchar byte = static_cast<uchar>(text[lead - 1]);
+    const qsizetype length = byte >= 0xF0 ? 4 : byte >= 0xE0 ? 3 : byte >= 0xC0 ? 2 : 1;
+    return text.size() - (lead - 1) < length ? lead - 1 : text.size();
+}
+
+// How a pass over a file ended
+enum class FileScan {
+    Valid,
+    NotUtf8,
+    ReadFailed
+};
+
+// Hands fn the normalized text of file one window at a time, leaving out
+// its first from bytes. The read buffer and window are reused, so memory
+// does not grow with the file. Stops early when fn returns false. NotUtf8
+// means the text seen so far is malformed; fn is given malformed bytes as
+// they are, for the encoder to skip. ReadFailed means the file shrank, see
+// file.errorString().
+template<typename Fn>
+FileScan forEachWindow(FileReader& file, QByteArray& window, qsizetype from, Fn fn)
+{
+    TextNormalizer normalizer;
+    window.clear();
+    window.reserve(FileWindowSize + 4);
+
+    auto result = [&normalizer]() {
+        return normalizer.stats().valid ? FileScan::Valid : FileScan::NotUtf8;
+    };
+
+    // Text before from is still read, it counts for the UTF-8 check
+    auto handOver = [&from, &fn](QByteArrayView text) {
+        const qsizetype skipped = qMin(from, text.size());
+        from -= skipped;
+        return skipped == text.size() || fn(text.sliced(skipped));
+    };
+
+    for (qsizetype offset = 0; offset < file.size(); offset += FileWindowSize) {
+        const qsizetype length = qMin(FileWindowSize, file.size() - offset);
+        const QByteArrayView data = file.read(offset, length);
+        if (data.isNull()) {
+            return FileScan::ReadFailed;
+        }
+        normalizer.feed(data, window);
+
+        // A character split between windows waits for the rest of it
+        const qsizetype complete = completeLength(window);
+        if (!handOver(QByteArrayView(window).first(complete))) {
+            return result();
+        }
+        window.remove(0, complete);
+    }
+
+    // Only a sequence truncated at the very end can be left; finish() flags it
+    normalizer.finish();
+    if (!window.isEmpty()) {
+        handOver(QByteArrayView(window));
+    }
+    return result();
+}
+}
+
+TypingWorker::TypingWorker(QObject* parent)
+    : QObject(parent)
+    , m_groupSize(1)
+    , m_groupFill(0)
+    , m_groupGapNs(0)
+    , m_cancelled(false)
+    , m_cancelRequestedNs(0)
+    , m_paused(false)
+    , m_realtime(false)
+    , m_lastGroupNs(0)
+{
+}
+
+TypingWorker::~TypingWorker() = default;
+
+bool TypingWorker::initialize()
+{
+    const bool ok = discoverBackend();
+    Q_EMIT initialized(ok);
+    return ok;
+}
+
+bool TypingWorker::discoverBackend()
+{
+    if (m_backend) {
+        return true;
+    }
+
+    // An explicit YDOTOOL_SOCKET wins, as it does for ydotool itself
+    const QString envSocket = qEnvironmentVariable("YDOTOOL_SOCKET");
+    if (!envSocket.isEmpty()) {
+        if (QFile::exists(envSocket)) {
+            qDebug() << "Using ydotoold socket from YDOTOOL_SOCKET";
+            return openSocketBackend(envSocket);
+        }
+        qWarning() << "YDOTOOL_SOCKET" << envSocket << "does not exist, ignoring it";
+    }
+
+    // Strategy 1: Create our own virtual keyboard, no daemon needed. Like
+    // a freshly started ydotoold below, the new device needs a moment before
+    // the compositor listens to it; the backend waits before its first write.
+    if (UinputBackend::isAvailable()) {
+        auto backend = std::make_unique<UinputBackend>();
+        if (backend->open()) {
+            m_backend = std::move(backend);
+            qDebug() << "Using uinput virtual keyboard";
+            return true;
+        }
+        qWarning() << backend->errorString() << "- trying ydotoold";
+    }
+
+    // Strategy 2: Check for system socket (AUR/packaged install)
+    QString socketPath;
+    QString systemSocket = QStringLiteral("/run/ydotool/socket");
+    QString userSocket = QStringLiteral("/run/user/%1/.ydotool_socket").arg(getuid());
+
+    if (QFile::exists(systemSocket)) {
+        socketPath = systemSocket;
+        qDebug() << "Using system ydotoold socket";
+    } else {
+        // Strategy 3: Fall back to user socket (development)
+        if (!QFile::exists(userSocket)) {
+            const QString daemon = QStandardPaths::findExecutable(QStringLiteral("ydotoold"));
+            if (!daemon.isEmpty()) {
+                // Try to start ydotoold as user daemon
+                qDebug() << "Starting user ydotoold daemon for development...";
+
+                QProcess::startDetached(daemon, {QStringLiteral("--socket-path"), userSocket,
+                                                 QStringLiteral("--socket-perm"), QStringLiteral("0600")});
+
+                // Only this thread waits; queued pastes run once we are done
+                if (!waitForFile(userSocket, SocketTimeoutMs)) {
+                    qWarning() << "ydotoold did not create" << userSocket << "in time";
+                }
+            }
+        }
+
+        if (QFile::exists(userSocket)) {
+            socketPath = userSocket;
+            qDebug() << "Using user ydotoold socket";
+        }
+    }
+
+    if (!socketPath.isEmpty()) {
+        return openSocketBackend(socketPath);
+    }
+
+    // Strategy 4: ydotool itself, for a daemon on a socket we do not know
+    auto cli = std::make_unique<YdotoolCliBackend>();
+    if (cli->open()) {
+        m_backend = std::move(cli);
+        qDebug() << "No ydotoold socket found, using the ydotool CLI";
+        return true;
+    }
+
+    // Neither worked
+    Q_EMIT errorOccurred(QStringLiteral("Could not open /dev/uinput or connect to ydotoold.\n\n"
+                                        "Add yourself to 'input' group:\n"
+                                        "  sudo usermod -aG input $USER\n"
+                                        "  (then log out and back in)\n\n"
+                                        "For production: Enable the systemd service:\n"
+                                        "  sudo systemctl enable --now ydotoold.service"));
+    return false;
+}
+
+bool TypingWorker::openSocketBackend(const QString& socketPath)
+{
+    // Prefer writing events to the daemon ourselves. The CLI is kept as
+    // the last resort for daemons whose socket protocol we do not speak.
+    m_backend = std::make_unique<YdotoolSocketBackend>(socketPath);
+    if (!m_backend->open()) {
+        const QString socketError = m_backend->errorString();
+        qWarning() << socketError << "- falling back to ydotool";
+        m_backend = std::make_unique<YdotoolCliBackend>(socketPath);
+        if (!m_backend->open()) {
+            Q_EMIT errorOccurred(socketError
+                                 + QStringLiteral("\n\nIs ydotoold running? Try: sudo systemctl start ydotoold"));
+            m_backend.reset();
+            return false;
+        }
+    }
+
+    qDebug() << "Input backend:" << m_backend->name();
+    return true;
+}
+
+void TypingWorker::setBackend(std::unique_ptr<InputBackend> backend)
+{
+    m_backend = std::move(backend);
+}
+
+void TypingWorker::cancel()
+{
+    qint64 none = 0;
+    m_cancelRequestedNs.compare_exchange_strong(none, Pacer::now());
+    m_cancelled = true;
+    m_pacer.interrupt();
+
+    // Also ends a pause; taking the lock orders this with the wait
+    { std::lock_guard<std::mutex> lock(m_pauseMutex); }
+    m_pauseCondition.notify_all();
+}
+
+void TypingWorker::resetCancel()
+{
+    m_cancelled = false;
+    m_cancelRequestedNs = 0;
+    m_paused = false;
+    m_pacer.clearInterrupt();
+}
+
+void TypingWorker::pause()
+{
+    m_paused = true;
+    m_pacer.interrupt();
+}
+
+void TypingWorker::resume()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_pauseMutex);
+        m_paused = false;
+    }
+    m_pauseCondition.notify_all();
+}
+
+bool TypingWorker::isPaused() const
+{
+    return m_paused;
+}
+
+void TypingWorker::typeText(const QByteArray& text, int characters, const TypingOptions& options)
+{
+    if (!beginSession(options)) {
+        return;
+    }
+    reportPlan(m_encoder.plan(text));
+    waitForStart(options);
+
+    // pos only advances past characters whose events reached the backend,
+    // so it is exactly where a cancelled paste can be picked up again
+    qsizetype pos = 0;
+    int typed = 0;
+    const bool ok = typeSpan(text, pos, typed, characters);
+    endSession(ok, pos, typed);
+}
+
+void TypingWorker::typeFile(const QString& path, const TypingOptions& options, qsizetype from)
+{
+    FileReader file;
+    if (!file.open(path)) {
+        Q_EMIT errorOccurred(file.errorString());
+        return;
+    }
+    if (file.size() == 0) {
+        Q_EMIT errorOccurred(QStringLiteral("%1 is empty").arg(path));
+        return;
+    }
+    if (!beginSession(options)) {
+        return;
+    }
+
+    // A first pass checks, counts and plans the characters, the second
+    // types them. Neither holds more than one window of the file.
+    EventEncoder::Plan plan;
+    const FileScan scan = forEachWindow(file, m_window, from, [&](QByteArrayView text) {
+        const EventEncoder::Plan part = m_encoder.plan(text);
+        plan.direct += part.direct;
+        plan.compose += part.compose;
+        plan.hexEntry += part.hexEntry;
+        plan.unmapped += part.unmapped;
+        return !m_cancelled;
+    });
+
+    if (scan == FileScan::ReadFailed) {
+        m_window = QByteArray();
+        finishSession(false);
+        Q_EMIT errorOccurred(file.errorString());
+        return;
+    }
+
+    // Latin-1 or binary files would come out as a mess of skipped bytes and
+    // hex entry, so nothing is typed from them
+    if (scan == FileScan::NotUtf8 && !m_cancelled) {
+        m_window = QByteArray();
+        finishSession(false);
+        Q_EMIT errorOccurred(QStringLiteral("%1 is not UTF-8 text").arg(path));
+        return;
+    }
+    reportPlan(plan);
+    const int characters = static_cast<int>(plan.direct + plan.slowPath() + plan.unmapped);
+
+    waitForStart(options);
+
+    bool ok = true;
+    qsizetype offset = 0;
+    int typed = 0;
+    const FileScan typedScan = forEachWindow(file, m_window, from, [&](QByteArrayView text) {
+        qsizetype pos = 0;
+        ok = typeSpan(text, pos, typed, characters);
+        offset += pos;
+        return ok && !m_cancelled;
+    });
+    m_window = QByteArray();
+
+    // Typing stops where the file was cut off
+    if (typedScan == FileScan::ReadFailed) {
+        endSession(false, offset, typed, file.errorString());
+        return;
+    }
+    endSession(ok, offset, typed);
+}
+
+bool TypingWorker::beginSession(const TypingOptions& options)
+{
+    if (!m_backend) {
+        Q_EMIT errorOccurred(QStringLiteral("No input backend available"));
+        return false;
+    }
+
+    Q_EMIT typingStarted();
+
+    m_report = PasteReport();
+    m_report.startedNs = Pacer::now();
+    m_lastGroupNs = 0;
+
+    m_encoder.setHexEntry(options.unicodeHexEntry);
+    m_encoder.setComposeKey(static_cast<quint16>(options.composeKey));
+    m_encoder.setCoalesceModifiers(options.coalesceModifiers);
+    m_encoder.resetModifiers();
+
+    if (options.realtimePacing != m_realtime) {
+        m_realtime = Pacer::setRealtime(options.realtimePacing) && options.realtimePacing;
+    }
+
+    // Keys go out in groups followed by a gap: one key per key delay, or a
+    // whole burst at full speed followed by the burst gap
+    if (options.burstSize > 0) {
+        m_groupSize = options.burstSize;
+        m_groupGapNs = options.burstGapMs * NsPerMs;
+    } else {
+        m_groupSize = 1;
+        m_groupGapNs = options.keyDelayMs * NsPerMs;
+    }
+    m_groupFill = 0;
+    return true;
+}
+
+void TypingWorker::reportPlan(const EventEncoder::Plan& plan)
+{
+    m_report.slowPathCharacters = static_cast<int>(plan.slowPath());
+    m_report.skippedCharacters = static_cast<int>(plan.unmapped);
+    Q_EMIT typingPlanned(m_report.slowPathCharacters, m_report.skippedCharacters);
+}
+
+void TypingWorker::waitForStart(const TypingOptions& options)
+{
+    // Start delay; keystrokes are scheduled relative to its deadline
+    m_pacer.start(options.startDelayMs * NsPerMs);
+    m_pacer.wait();
+
+    // The event buffer is reused so memory stays flat regardless of the
+    // paste size
+    m_buffer.reserve(ChunkSize * EventEncoder::MaxEventsPerKey);
+}
+
+bool TypingWorker::typeSpan(QByteArrayView text, qsizetype& pos, int& typed, int characters)
+{
+    // Stream the text in bounded chunks
+    const qsizetype size = text.size();
+    while (pos < size && !m_cancelled) {
+        if (m_paused) {
+            waitWhilePaused(typed, characters);
+            continue;
+        }
+
+        // Keep UTF-8 sequences together
+        const qsizetype end = sequenceEnd(text, qMin<qsizetype>(pos + ChunkSize, size));
+
+        const QByteArrayView chunk = text.sliced(pos, end - pos);
+        qsizetype consumed = 0;
+        if (!typeChunk(chunk, consumed)) {
+            return false;
+        }
+
+        const QByteArrayView done = chunk.first(consumed);
+        pos += consumed;
+        typed += static_cast<int>(done.size() - std::count_if(done.begin(), done.end(), isContinuationByte));
+        if (consumed < chunk.size() && !m_cancelled && !m_paused) {
+            // A pause that was lifted before we got to it
+            m_pacer.clearInterrupt();
+        }
+        if (!m_cancelled) {
+            Q_EMIT typingProgress(typed, characters);
+        }
+    }
+    return true;
+}
+
+void TypingWorker::endSession(bool ok, qsizetype offset, int typed, const QString& error)
+{
+    // Whatever is still down goes up in one write, before anything else
+    releaseHeldKeys();
+    m_buffer.clear();
+    m_report.characters = typed;
+
+    if (m_cancelled) {
+        finishSession(true);
+        Q_EMIT typingCancelled(offset, typed);
+    } else if (!ok) {
+        finishSession(false);
+        Q_EMIT errorOccurred(error.isEmpty() ? m_backend->errorString() : error);
+    } else {
+        finishSession(false);
+        Q_EMIT typingFinished();
+    }
+}
+
+void TypingWorker::finishSession(bool cancelled)
+{
+    m_report.finishedNs = Pacer::now();
+    m_report.cancelled = cancelled;
+    const qint64 cancelRequested = m_cancelRequestedNs;
+    if (cancelled && cancelRequested > 0) {
+        m_report.cancelLatencyNs = m_report.finishedNs - cancelRequested;
+    }
+    Q_EMIT sessionFinished(m_report);
+}
+
+void TypingWorker::waitWhilePaused(int typed, int characters)
+{
+    // Nothing stays down while the user has the keyboard
+    releaseHeldKeys();
+    Q_EMIT typingPaused(typed, characters);
+
+    {
+        std::unique_lock<std::mutex> lock(m_pauseMutex);
+        m_pauseCondition.wait(lock, [this]() { return !m_paused || m_cancelled; });
+    }
+
+    // Drop the pause's wakeup; a cancel still shows in m_cancelled
+    m_pacer.clearInterrupt();
+    if (m_cancelled) {
+        return;
+    }
+
+    // The time spent paused is not part of the schedule
+    m_groupFill = 0;
+    m_lastGroupNs = 0;
+    m_pacer.start(0);
+    Q_EMIT typingResumed();
+}
+
+bool TypingWorker::typeChunk(QByteArrayView chunk, qsizetype& consumed)
+{
+    m_buffer.clear();
+    consumed = chunk.size();
+
+    // Without any gap the chunk goes out in a few writes as fast as the
+    // backend takes them, with a check for cancel or pause after each one
+    if (m_groupGapNs <= 0) {
+        const qsizetype sliceSize = qMax(1, m_backend->preferredWriteSize() / EventEncoder::MaxEventsPerKey);
+        for (qsizetype i = 0; i < chunk.size();) {
+            const qsizetype end = sequenceEnd(chunk, qMin(i + sliceSize, chunk.size()));
+
+            const qint64 encodeStart = Pacer::now();
+            m_encoder.encode(chunk.sliced(i, end - i), m_buffer);
+            m_report.encodeNs += Pacer::now() - encodeStart;
+            if (!flushEvents()) {
+                return false;
+            }
+
+            i = end;
+            if (m_cancelled || m_paused) {
+                consumed = i;
+                break;
+            }
+        }
+        return true;
+    }
+
+    for (qsizetype i = 0; i < chunk.size();) {
+        const qint64 encodeStart = Pacer::now();
+        const char32_t ch = EventEncoder::nextCodePoint(chunk, i);
+        const int count = m_encoder.encodeCharacter(ch, m_buffer.prepare(EventEncoder::MaxEventsPerChar));
+        m_report.encodeNs += Pacer::now() - encodeStart;
+        if (count == 0) {
+            // No key and no fallback for it; counted in the plan
+            continue;
+        }
+        m_buffer.commit(count);
+
+        if (++m_groupFill < m_groupSize) {
+            continue;
+        }
+        m_groupFill = 0;
+
+        if (!flushEvents()) {
+            return false;
+        }
+
+        // Distance between whole groups against the configured gap
+        const qint64 now = Pacer::now();
+        if (m_lastGroupNs > 0) {
+            m_report.jitterNs.record(qAbs(now - m_lastGroupNs - m_groupGapNs));
+        }
+        m_lastGroupNs = now;
+
+        // Everything up to i is out; stop here when interrupted
+        m_pacer.advance(m_groupGapNs);
+        if (!m_pacer.wait() || m_paused) {
+            consumed = i;
+            return true;
+        }
+    }
+
+    // A partial burst is sent now and completed by the next chunk
+    return flushEvents();
+}
+
+bool TypingWorker::flushEvents()
+{
+    if (m_buffer.isEmpty()) {
+        return true;
+    }
+
+    const bool ok = m_backend->writeEvents(m_buffer.data(), m_buffer.size());
+    if (ok) {
+        m_keys.apply(m_buffer.data(), m_buffer.size());
+    } else {
+        m_keys.assumePressed(m_buffer.data(), m_buffer.size());
+    }
+    m_buffer.clear();
+    if (ok && m_report.firstKeyNs == 0) {
+        m_report.firstKeyNs = Pacer::now();
+    }
+    return ok;
+}
+
+void TypingWorker::releaseHeldKeys()
+{
+    // Characters are written whole, so this usually holds at most a Shift
+    // kept down for a run. After a failed write it lifts whatever may have
+    // gone down.
+    m_encoder.resetModifiers();
+    if (m_keys.isEmpty()) {
+        return;
+    }
+
+    m_buffer.clear();
+    input_event* start = m_buffer.prepare(m_keys.count() + 1);
+    m_buffer.commit(static_cast<int>(m_keys.writeRelease(start) - start));
+    if (!m_backend->writeEvents(m_buffer.data(), m_buffer.size())) {
+        qWarning() << "Failed to release keys:" << m_backend->errorString();
+    }
+    m_buffer.clear();
+    m_keys.clear();
+}
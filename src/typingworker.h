@@ -0,0 +1,105 @@
+#ifndef TYPINGWORKER_H
+#define TYPINGWORKER_H
+
+#include "eventencoder.h"
+#include "pacer.h"
+#include "pastereport.h"
+#include "typingoptions.h"
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QObject>
+#include <QString>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
+class InputBackend;
+
+// Owns the input backend and does the actual typing. Lives on its own
+// thread; jobs arrive as queued calls from InputEmulator.
+class TypingWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit TypingWorker(QObject* parent = nullptr);
+    ~TypingWorker();
+
+    // Uses backend instead of discovering one; for benchmarks and tests
+    void setBackend(std::unique_ptr<InputBackend> backend);
+
+    // Thread-safe, may be called from any thread
+    void cancel();
+    void resetCancel();
+
+    // Thread-safe. Typing stops after the key being typed and holds no
+    // keys down until resume() or cancel().
+    void pause();
+    void resume();
+    bool isPaused() const;
+
+public Q_SLOTS:
+    // Finds and opens an input backend, then emits initialized()
+    bool initialize();
+    // text is normalized UTF-8 holding characters code points
+    void typeText(const QByteArray& text, int characters, const TypingOptions& options);
+    // Streams the file from disk; memory use does not depend on its size.
+    // A file that is not UTF-8 is refused before anything is typed. from is
+    // a byte offset into the normalized text, as typingCancelled() reports.
+    void typeFile(const QString& path, const TypingOptions& options, qsizetype from = 0);
+
+Q_SIGNALS:
+    void initialized(bool ok);
+    void typingStarted();
+    // Before the first key: characters that take a Compose or hex entry
+    // sequence, and characters that cannot be typed at all
+    void typingPlanned(int slowPath, int skipped);
+    void typingProgress(int current, int total);
+    void typingPaused(int current, int total);
+    void typingResumed();
+    void typingFinished();
+    // offset is the byte offset of the first character not typed
+    void typingCancelled(qsizetype offset, int typed);
+    void errorOccurred(const QString& error);
+
+    // Emitted after every paste, before the signal that ends it
+    void sessionFinished(const PasteReport& report);
+
+private:
+    bool discoverBackend();
+    bool openSocketBackend(const QString& socketPath);
+    bool beginSession(const TypingOptions& options);
+    void reportPlan(const EventEncoder::Plan& plan);
+    void waitForStart(const TypingOptions& options);
+    bool typeSpan(QByteArrayView text, qsizetype& pos, int& typed, int characters);
+    // error replaces the backend's error string when ok is false
+    void endSession(bool ok, qsizetype offset, int typed, const QString& error = QString());
+    bool typeChunk(QByteArrayView chunk, qsizetype& consumed);
+    bool flushEvents();
+    void finishSession(bool cancelled);
+    void releaseHeldKeys();
+    void waitWhilePaused(int typed, int characters);
+
+    std::unique_ptr<InputBackend> m_backend;
+    EventEncoder m_encoder;
+    EventBuffer m_buffer;
+    QByteArray m_window;
+    KeyState m_keys;
+    Pacer m_pacer;
+    int m_groupSize;
+    int m_groupFill;
+    qint64 m_groupGapNs;
+    std::atomic<bool> m_cancelled;
+    std::atomic<qint64> m_cancelRequestedNs;
+    std::atomic<bool> m_paused;
+    std::mutex m_pauseMutex;
+    std::condition_variable m_pauseCondition;
+    bool m_realtime;
+
+    PasteReport m_report;
+    qint64 m_lastGroupNs;
+};
+
+#endif // TYPINGWORKER_H
@@ -0,0 +1,143 @@
+#include "uinputbackend.h"
+#include "pacer.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/uinput.h>
+#include <sys/ioctl.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace {
+const char UinputPath[] = "/dev/uinput";
+
+// libinput and the compositor only pick up a new device after udev has
+// announced it; keys written before then are lost
+constexpr qint64 SettleNs = 200 * 1000 * 1000;
+
+QString lastError()
+{
+    return QString::fromLocal8Bit(strerror(errno));
+}
+}
+
+UinputBackend::UinputBackend()
+    : m_fd(-1)
+    , m_readyNs(0)
+{
+}
+
+UinputBackend::~UinputBackend()
+{
+    close();
+}
+
+bool UinputBackend::isAvailable()
+{
+    return ::access(UinputPath, W_OK) == 0;
+}
+
+QString UinputBackend::name() const
+{
+    return QStringLiteral("uinput");
+}
+
+bool UinputBackend::open()
+{
+    if (m_fd >= 0) {
+        return true;
+    }
+
+    m_fd = ::open(UinputPath, O_WRONLY | O_CLOEXEC);
+    if (m_fd < 0) {
+        setErrorString(QStringLiteral("Could not open /dev/uinput: %1").arg(lastError()));
+        return false;
+    }
+
+    bool ok = ::ioctl(m_fd, UI_SET_EVBIT, EV_KEY) == 0
+           && ::ioctl(m_fd, UI_SET_EVBIT, EV_SYN) == 0;
+
+    // Advertise the full keyboard range so the compositor treats us as a keyboard
+    for (int key = KEY_ESC; ok && key <= KEY_MICMUTE; ++key) {
+        ok = ::ioctl(m_fd, UI_SET_KEYBIT, key) == 0;
+    }
+
+    if (ok) {
+        uinput_setup setup;
+        std::memset(&setup, 0, sizeof(setup));
+        setup.id.bustype = BUS_VIRTUAL;
+        setup.id.vendor = 0x1209;
+        setup.id.product = 0xc11c;
+        std::strncpy(setup.name, "ClickPaste virtual keyboard", UINPUT_MAX_NAME_SIZE - 1);
+
+        ok = ::ioctl(m_fd, UI_DEV_SETUP, &setup) == 0
+          && ::ioctl(m_fd, UI_DEV_CREATE) == 0;
+    }
+
+    if (!ok) {
+        setErrorString(QStringLiteral("Could not create uinput device: %1").arg(lastError()));
+        ::close(m_fd);
+        m_fd = -1;
+        return false;
+    }
+
+    // The first write waits out the rest, so a start delay overlaps it
+    m_readyNs = Pacer::now() + SettleNs;
+    return true;
+}
+
+void UinputBackend::close()
+{
+    if (m_fd >= 0) {
+        ::ioctl(m_fd, UI_DEV_DESTROY);
+        ::close(m_fd);
+        m_fd = -1;
+    }
+}
+
+bool UinputBackend::isOpen() const
+{
+    return m_fd >= 0;
+}
+
+bool UinputBackend::writeEvents(const input_event* events, int count)
+{
+    if (m_fd < 0) {
+        setErrorString(QStringLiteral("uinput device is not open"));
+        return false;
+    }
+
+    if (m_readyNs > 0) {
+        waitUntilReady();
+    }
+
+    // uinput accepts any number of whole events per write()
+    const char* data = reinterpret_cast<const char*>(events);
+    size_t remaining = sizeof(input_event) * count;
+    while (remaining > 0) {
+        const ssize_t written = ::write(m_fd, data, remaining);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            setErrorString(QStringLiteral("Could not write to uinput: %1").arg(lastError()));
+            return false;
+        }
+        data += written;
+        remaining -= written;
+    }
+
+    return true;
+}
+
+void UinputBackend::waitUntilReady()
+{
+    // m_readyNs is on Pacer::now()'s clock, CLOCK_MONOTONIC
+    timespec deadline;
+    deadline.tv_sec = m_readyNs / 1000000000;
+    deadline.tv_nsec = m_readyNs % 1000000000;
+    while (::clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr) == EINTR) {
+    }
+    m_readyNs = 0;
+}
@@ -0,0 +1,34 @@
+#ifndef UINPUTBACKEND_H
+#define UINPUTBACKEND_H
+
+#include "inputbackend.h"
+
+// Creates our own virtual keyboard through /dev/uinput, so no ydotoold is
+// needed. Requires write access to /dev/uinput (usually the input group).
+// The first write after creating the device waits until the compositor
+// can have seen it.
+class UinputBackend : public InputBackend
+{
+public:
+    UinputBackend();
+    ~UinputBackend() override;
+
+    static bool isAvailable();
+
+    QString name() const override;
+
+    bool open() override;
+    void close() override;
+    bool isOpen() const override;
+
+    bool writeEvents(const input_event* events, int count) override;
+
+private:
+    void waitUntilReady();
+
+    int m_fd;
+    // When the new device is usable, 0 once it is
+    qint64 m_readyNs;
+};
+
+#endif // UINPUTBACKEND_H
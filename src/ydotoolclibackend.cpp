@@ -0,0 +1,75 @@
+#include "ydotoolclibackend.h"
+
+#include <QProcess>
+#include <QProcessEnvironment>
+#include <QStandardPaths>
+#include <QStringList>
+
+YdotoolCliBackend::YdotoolCliBackend(const QString& socketPath)
+    : m_socketPath(socketPath)
+{
+}
+
+QString YdotoolCliBackend::name() const
+{
+    return QStringLiteral("ydotool");
+}
+
+bool YdotoolCliBackend::open()
+{
+    if (m_program.isEmpty()) {
+        m_program = QStandardPaths::findExecutable(QStringLiteral("ydotool"));
+    }
+    if (m_program.isEmpty()) {
+        setErrorString(QStringLiteral("ydotool not found. Please install: sudo pacman -S ydotool"));
+        return false;
+    }
+    return true;
+}
+
+void YdotoolCliBackend::close()
+{
+}
+
+bool YdotoolCliBackend::isOpen() const
+{
+    return !m_program.isEmpty();
+}
+
+bool YdotoolCliBackend::writeEvents(const input_event* events, int count)
+{
+    if (!open()) {
+        return false;
+    }
+
+    // ydotool key takes <code>:<value> pairs and emits SYN after each one
+    QStringList args;
+    args << QStringLiteral("key") << QStringLiteral("--key-delay") << QStringLiteral("0");
+    for (int i = 0; i < count; ++i) {
+        if (events[i].type == EV_KEY) {
+            args << QStringLiteral("%1:%2").arg(events[i].code).arg(events[i].value);
+        }
+    }
+    if (args.size() == 3) {
+        return true;
+    }
+
+    QProcess process;
+    if (!m_socketPath.isEmpty()) {
+        QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+        env.insert(QStringLiteral("YDOTOOL_SOCKET"), m_socketPath);
+        process.setProcessEnvironment(env);
+    }
+    process.start(m_program, args);
+
+    if (!process.waitForFinished(5000) || process.exitCode() != 0) {
+        QString errorOutput = QString::fromUtf8(process.readAllStandardError());
+        if (errorOutput.isEmpty()) {
+            errorOutput = QStringLiteral("ydotool failed. Is ydotoold running? Try: sudo systemctl start ydotoold");
+        }
+        setErrorString(errorOutput);
+        return false;
+    }
+
+    return true;
+}
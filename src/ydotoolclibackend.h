@@ -0,0 +1,31 @@
+#ifndef YDOTOOLCLIBACKEND_H
+#define YDOTOOLCLIBACKEND_H
+
+#include "inputbackend.h"
+
+// Last resort that replays key events through `ydotool key`. Slower than
+// talking to the socket, but works with any ydotool build and with a
+// daemon on a socket only ydotool itself knows about.
+class YdotoolCliBackend : public InputBackend
+{
+public:
+    // An empty socketPath leaves the choice of socket to ydotool
+    explicit YdotoolCliBackend(const QString& socketPath = QString());
+    ~YdotoolCliBackend() override = default;
+
+    QString name() const override;
+
+    bool open() override;
+    void close() override;
+    bool isOpen() const override;
+
+    bool writeEvents(const input_event* events, int count) override;
+    // Every write starts a process, so keep them few
+    int preferredWriteSize() const override { return 4096; }
+
+private:
+    QString m_socketPath;
+    QString m_program;
+};
+
+#endif // YDOTOOLCLIBACKEND_H
@@ -0,0 +1,128 @@
+#include "ydotoolsocketbackend.h"
+
+#include <QFile>
+
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+// sendmmsg() batch size; one message per event
+constexpr int BatchSize = 64;
+}
+
+YdotoolSocketBackend::YdotoolSocketBackend(const QString& socketPath)
+    : m_socketPath(socketPath)
+    , m_fd(-1)
+{
+}
+
+YdotoolSocketBackend::~YdotoolSocketBackend()
+{
+    close();
+}
+
+QString YdotoolSocketBackend::name() const
+{
+    return QStringLiteral("ydotoold socket");
+}
+
+bool YdotoolSocketBackend::open()
+{
+    if (m_fd >= 0) {
+        return true;
+    }
+
+    const QByteArray path = QFile::encodeName(m_socketPath);
+
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= static_cast<int>(sizeof(addr.sun_path))) {
+        setErrorString(QStringLiteral("ydotoold socket path is too long: %1").arg(m_socketPath));
+        return false;
+    }
+    std::memcpy(addr.sun_path, path.constData(), path.size());
+
+    m_fd = ::socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (m_fd < 0) {
+        setErrorString(QStringLiteral("Could not create socket: %1").arg(QString::fromLocal8Bit(strerror(errno))));
+        return false;
+    }
+
+    if (::connect(m_fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0) {
+        setErrorString(QStringLiteral("Could not connect to ydotoold at %1: %2")
+                           .arg(m_socketPath, QString::fromLocal8Bit(strerror(errno))));
+        ::close(m_fd);
+        m_fd = -1;
+        return false;
+    }
+
+    return true;
+}
+
+void YdotoolSocketBackend::close()
+{
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+}
+
+bool YdotoolSocketBackend::isOpen() const
+{
+    return m_fd >= 0;
+}
+
+bool YdotoolSocketBackend::writeEvents(const input_event* events, int count)
+{
+    if (!open()) {
+        return false;
+    }
+
+    if (sendAll(events, count)) {
+        return true;
+    }
+
+    // ydotoold may have been restarted since we connected; reconnect once
+    if (errno == ECONNREFUSED || errno == ENOTCONN) {
+        close();
+        if (open() && sendAll(events, count)) {
+            return true;
+        }
+    }
+
+    setErrorString(QStringLiteral("Could not write to ydotoold: %1").arg(QString::fromLocal8Bit(strerror(errno))));
+    return false;
+}
+
+bool YdotoolSocketBackend::sendAll(const input_event* events, int count)
+{
+    mmsghdr messages[BatchSize];
+    iovec vectors[BatchSize];
+
+    int sent = 0;
+    while (sent < count) {
+        const int batch = qMin(count - sent, BatchSize);
+        std::memset(messages, 0, sizeof(mmsghdr) * batch);
+        for (int i = 0; i < batch; ++i) {
+            vectors[i].iov_base = const_cast<input_event*>(&events[sent + i]);
+            vectors[i].iov_len = sizeof(input_event);
+            messages[i].msg_hdr.msg_iov = &vectors[i];
+            messages[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        const int result = ::sendmmsg(m_fd, messages, batch, 0);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        sent += result;
+    }
+
+    return true;
+}
@@ -0,0 +1,29 @@
+#ifndef YDOTOOLSOCKETBACKEND_H
+#define YDOTOOLSOCKETBACKEND_H
+
+#include "inputbackend.h"
+
+// Talks to ydotoold directly: one datagram per input_event, which is the
+// same wire format the ydotool client uses.
+class YdotoolSocketBackend : public InputBackend
+{
+public:
+    explicit YdotoolSocketBackend(const QString& socketPath);
+    ~YdotoolSocketBackend() override;
+
+    QString name() const override;
+
+    bool open() override;
+    void close() override;
+    bool isOpen() const override;
+
+    bool writeEvents(const input_event* events, int count) override;
+
+private:
+    bool sendAll(const input_event* events, int count);
+
+    QString m_socketPath;
+    int m_fd;
+};
+
+#endif // YDOTOOLSOCKETBACKEND_H
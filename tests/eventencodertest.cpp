@@ -0,0 +1,129 @@
+#include "eventencoder.h"
+
+#include <QByteArray>
+#include <QTest>
+
+namespace {
+
+QByteArray toUtf8(char32_t ch)
+{
+    QByteArray out;
+    if (ch < 0x80) {
+        out.append(char(ch));
+    } else if (ch < 0x800) {
+        out.append(char(0xC0 | (ch >> 6)));
+        out.append(char(0x80 | (ch & 0x3F)));
+    } else if (ch < 0x10000) {
+        out.append(char(0xE0 | (ch >> 12)));
+        out.append(char(0x80 | ((ch >> 6) & 0x3F)));
+        out.append(char(0x80 | (ch & 0x3F)));
+    } else {
+        out.append(char(0xF0 | (ch >> 18)));
+        out.append(char(0x80 | ((ch >> 12) & 0x3F)));
+        out.append(char(0x80 | ((ch >> 6) & 0x3F)));
+        out.append(char(0x80 | (ch & 0x3F)));
+    }
+    return out;
+}
+
+QByteArray repeated(const char* unit, int times)
+{
+    QByteArray text;
+    for (int i = 0; i < times; ++i) {
+        text.append(unit);
+    }
+    return text;
+}
+
+} // namespace
+
+class EventEncoderTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void malformedInput_data();
+    void malformedInput();
+    void replacementCharacter();
+    void fallbacksFitReservation();
+};
+
+void EventEncoderTest::malformedInput_data()
+{
+    QTest::addColumn<QByteArray>("text");
+    QTest::addColumn<int>("skipped");
+
+    QTest::newRow("continuation run") << QByteArray(200, '\x80') << 200;
+    QTest::newRow("lead bytes") << QByteArray(200, '\xC3') << 200;
+    QTest::newRow("truncated") << repeated("\xF0\x9F\x98", 50) << 150;
+    QTest::newRow("overlong") << repeated("\xC0\xAF", 100) << 200;
+    QTest::newRow("surrogates") << repeated("\xED\xA0\x80", 60) << 180;
+    QTest::newRow("mixed") << repeated("A\x80" "b\xE2\x82", 40) << 120;
+}
+
+void EventEncoderTest::malformedInput()
+{
+    QFETCH(QByteArray, text);
+    QFETCH(int, skipped);
+
+    for (bool coalesce : {false, true}) {
+        EventEncoder encoder;
+        encoder.setHexEntry(true);
+        encoder.setComposeKey(KEY_RIGHTALT);
+        encoder.setCoalesceModifiers(coalesce);
+
+        // Malformed bytes are skipped, never typed as hex entry
+        const EventEncoder::Plan plan = encoder.plan(text);
+        QCOMPARE(plan.slowPath(), qsizetype(0));
+        QCOMPARE(plan.unmapped, qsizetype(skipped));
+
+        EventBuffer buffer;
+        QCOMPARE(encoder.encode(text, buffer), skipped);
+        QVERIFY(buffer.size() <= text.size() * EventEncoder::MaxEventsPerByte);
+    }
+}
+
+void EventEncoderTest::replacementCharacter()
+{
+    // A U+FFFD that is really in the text is typed like any other character
+    const QByteArray text("\xEF\xBF\xBD");
+    qsizetype index = 0;
+    QCOMPARE(EventEncoder::nextCodePoint(text, index), char32_t(0xFFFD));
+    QCOMPARE(index, qsizetype(3));
+
+    EventEncoder encoder;
+    encoder.setHexEntry(true);
+    QCOMPARE(encoder.path(0xFFFD), EventEncoder::HexEntry);
+
+    EventBuffer buffer;
+    QCOMPARE(encoder.encode(text, buffer), 0);
+    QVERIFY(buffer.size() > 0);
+}
+
+void EventEncoderTest::fallbacksFitReservation()
+{
+    // encode() reserves MaxEventsPerByte per byte; check every character
+    // against that, after a capital so a held Shift has to be released
+    EventEncoder encoder;
+    encoder.setHexEntry(true);
+    encoder.setComposeKey(KEY_RIGHTALT);
+    encoder.setCoalesceModifiers(true);
+
+    input_event events[EventEncoder::MaxEventsPerKey + EventEncoder::MaxEventsPerChar];
+    for (char32_t ch = 0xA0; ch <= 0x10FFFF; ++ch) {
+        if (ch >= 0xD800 && ch <= 0xDFFF) {
+            continue;
+        }
+        encoder.resetModifiers();
+        const int shift = encoder.encodeCharacter(U'A', events);
+        const int count = encoder.encodeCharacter(ch, events + shift);
+        const int limit = static_cast<int>(toUtf8(ch).size()) * EventEncoder::MaxEventsPerByte;
+        if (count > limit || count > EventEncoder::MaxEventsPerChar) {
+            QFAIL(qPrintable(QStringLiteral("U+%1 takes %2 events").arg(uint(ch), 4, 16, QLatin1Char('0')).arg(count)));
+        }
+    }
+}
+
+QTEST_GUILESS_MAIN(EventEncoderTest)
+
+#include "eventencodertest.moc"